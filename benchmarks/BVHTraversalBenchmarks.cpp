@@ -0,0 +1,198 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Compares visiting the draw cache tree through a std::function against a templated visitor, which is how
+// DrawingProgramCache::traverse_bvh_run_function* and node_loop_*_components work. DrawingProgramCache itself needs a World,
+// so a synthetic quadtree with the same traversal shape is used instead. The tree holds one million components, with up to 50
+// components in each leaf (matching MAXIMUM_COMPONENTS_IN_SINGLE_NODE)
+// Run with: ./infinipaint_benchmarks --benchmark_filter=Traverse
+
+#include "SharedTypes.hpp"
+#include <Helpers/SCollision.hpp>
+#include <benchmark/benchmark.h>
+#include <functional>
+#include <memory>
+#include <random>
+
+namespace {
+
+constexpr size_t COMPONENT_COUNT = 1000000;
+constexpr size_t MAXIMUM_COMPONENTS_IN_LEAF = 50;
+
+struct SyntheticComponent {
+    SCollision::AABB<WorldScalar> bounds;
+    uint64_t pos;
+};
+
+struct SyntheticNode {
+    SCollision::AABB<WorldScalar> bounds;
+    std::vector<SyntheticComponent*> components;
+    std::vector<std::shared_ptr<SyntheticNode>> children;
+};
+
+struct SyntheticTree {
+    std::vector<SyntheticComponent> components;
+    std::shared_ptr<SyntheticNode> root;
+};
+
+void build_synthetic_node(const std::shared_ptr<SyntheticNode>& node, std::vector<SyntheticComponent*> components) {
+    if(components.size() <= MAXIMUM_COMPONENTS_IN_LEAF) {
+        node->components = std::move(components);
+        return;
+    }
+    WorldVec center = node->bounds.center();
+    std::array<std::vector<SyntheticComponent*>, 4> parts;
+    for(SyntheticComponent* c : components) {
+        WorldVec cCenter = c->bounds.center();
+        parts[(cCenter.x() >= center.x() ? 1 : 0) + (cCenter.y() >= center.y() ? 2 : 0)].emplace_back(c);
+    }
+    for(size_t i = 0; i < 4; i++) {
+        auto child = std::make_shared<SyntheticNode>();
+        child->bounds = SCollision::AABB<WorldScalar>(WorldVec{(i & 1) ? center.x() : node->bounds.min.x(), (i & 2) ? center.y() : node->bounds.min.y()},
+                                                      WorldVec{(i & 1) ? node->bounds.max.x() : center.x(), (i & 2) ? node->bounds.max.y() : center.y()});
+        build_synthetic_node(child, std::move(parts[i]));
+        node->children.emplace_back(child);
+    }
+}
+
+// Components scattered over a square canvas, each a stroke of a few units wide. Built once and shared between benchmarks
+const SyntheticTree& get_synthetic_tree() {
+    static SyntheticTree tree = [] {
+        SyntheticTree toRet;
+        std::mt19937 gen(1);
+        std::uniform_real_distribution<double> posDist(0.0, 100000.0);
+        std::uniform_real_distribution<double> sizeDist(1.0, 20.0);
+        toRet.components.resize(COMPONENT_COUNT);
+        for(size_t i = 0; i < COMPONENT_COUNT; i++) {
+            WorldVec p{WorldScalar(posDist(gen)), WorldScalar(posDist(gen))};
+            toRet.components[i].bounds = SCollision::AABB<WorldScalar>(p, p + WorldVec{WorldScalar(sizeDist(gen)), WorldScalar(sizeDist(gen))});
+            toRet.components[i].pos = i;
+        }
+        std::vector<SyntheticComponent*> componentPtrs(COMPONENT_COUNT);
+        for(size_t i = 0; i < COMPONENT_COUNT; i++)
+            componentPtrs[i] = &toRet.components[i];
+        toRet.root = std::make_shared<SyntheticNode>();
+        toRet.root->bounds = SCollision::AABB<WorldScalar>(WorldVec{WorldScalar(0), WorldScalar(0)}, WorldVec{WorldScalar(100020), WorldScalar(100020)});
+        build_synthetic_node(toRet.root, std::move(componentPtrs));
+        return toRet;
+    }();
+    return tree;
+}
+
+// Same shape as the traversal functions before they were templated
+void traverse_std_function(const std::shared_ptr<SyntheticNode>& node, const SCollision::AABB<WorldScalar>& aabb, std::function<bool(const std::shared_ptr<SyntheticNode>&)> f) {
+    if(node && SCollision::collide(aabb, node->bounds) && f(node)) {
+        for(auto& p : node->children)
+            traverse_std_function(p, aabb, f);
+    }
+}
+
+void node_loop_components_std_function(const std::shared_ptr<SyntheticNode>& node, std::function<void(SyntheticComponent*)> f) {
+    std::for_each(node->components.begin(), node->components.end(), f);
+}
+
+template <typename F> void traverse_templated(const std::shared_ptr<SyntheticNode>& node, const SCollision::AABB<WorldScalar>& aabb, F&& f) {
+    if(node && SCollision::collide(aabb, node->bounds) && f(node)) {
+        for(auto& p : node->children)
+            traverse_templated(p, aabb, f);
+    }
+}
+
+template <typename F> void node_loop_components_templated(const std::shared_ptr<SyntheticNode>& node, F&& f) {
+    for(SyntheticComponent* c : node->components)
+        f(c);
+}
+
+// Query covering the fraction of the canvas given by the benchmark argument, in percent
+SCollision::AABB<WorldScalar> query_bounds(int64_t percentCovered) {
+    double width = 100000.0 * std::sqrt(static_cast<double>(percentCovered) / 100.0);
+    return SCollision::AABB<WorldScalar>(WorldVec{WorldScalar(0), WorldScalar(0)}, WorldVec{WorldScalar(width), WorldScalar(width)});
+}
+
+void coverage_args(benchmark::internal::Benchmark* b) {
+    for(int percentCovered : {1, 10, 100})
+        b->Arg(percentCovered);
+    b->ArgName("percentCovered");
+}
+
+// Finds the front component colliding with the query, like DrawingProgramCache::get_front_object_colliding_with_in_editing_layer
+void BM_TraverseComponentsStdFunction(benchmark::State& state) {
+    const SyntheticTree& tree = get_synthetic_tree();
+    SCollision::AABB<WorldScalar> aabb = query_bounds(state.range(0));
+    for(auto _ : state) {
+        SyntheticComponent* front = nullptr;
+        traverse_std_function(tree.root, aabb, [&](const std::shared_ptr<SyntheticNode>& node) {
+            node_loop_components_std_function(node, [&](SyntheticComponent* c) {
+                if((!front || c->pos >= front->pos) && SCollision::collide(aabb, c->bounds))
+                    front = c;
+            });
+            return true;
+        });
+        benchmark::DoNotOptimize(front);
+    }
+}
+
+void BM_TraverseComponentsTemplated(benchmark::State& state) {
+    const SyntheticTree& tree = get_synthetic_tree();
+    SCollision::AABB<WorldScalar> aabb = query_bounds(state.range(0));
+    for(auto _ : state) {
+        SyntheticComponent* front = nullptr;
+        traverse_templated(tree.root, aabb, [&](const std::shared_ptr<SyntheticNode>& node) {
+            node_loop_components_templated(node, [&](SyntheticComponent* c) {
+                if((!front || c->pos >= front->pos) && SCollision::collide(aabb, c->bounds))
+                    front = c;
+            });
+            return true;
+        });
+        benchmark::DoNotOptimize(front);
+    }
+}
+
+// Only visits the nodes, like collecting the nodes to draw in DrawingProgramCache::draw_components_to_canvas
+void BM_TraverseNodesStdFunction(benchmark::State& state) {
+    const SyntheticTree& tree = get_synthetic_tree();
+    SCollision::AABB<WorldScalar> aabb = query_bounds(state.range(0));
+    for(auto _ : state) {
+        size_t nodeCount = 0;
+        traverse_std_function(tree.root, aabb, [&](const std::shared_ptr<SyntheticNode>&) {
+            nodeCount++;
+            return true;
+        });
+        benchmark::DoNotOptimize(nodeCount);
+    }
+}
+
+void BM_TraverseNodesTemplated(benchmark::State& state) {
+    const SyntheticTree& tree = get_synthetic_tree();
+    SCollision::AABB<WorldScalar> aabb = query_bounds(state.range(0));
+    for(auto _ : state) {
+        size_t nodeCount = 0;
+        traverse_templated(tree.root, aabb, [&](const std::shared_ptr<SyntheticNode>&) {
+            nodeCount++;
+            return true;
+        });
+        benchmark::DoNotOptimize(nodeCount);
+    }
+}
+
+}
+
+BENCHMARK(BM_TraverseComponentsStdFunction)->Apply(coverage_args)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TraverseComponentsTemplated)->Apply(coverage_args)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TraverseNodesStdFunction)->Apply(coverage_args)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TraverseNodesTemplated)->Apply(coverage_args)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,207 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Microbenchmarks for the fixed point world math. Each benchmark is run at several canvas magnitudes, from a fresh canvas
+// (values that fit in the inline integer) up to a canvas that has been scaled up 50 times (values thousands of bits wide)
+// Run with: ./infinipaint_benchmarks --benchmark_filter=<regex>
+
+#include "CoordSpaceHelper.hpp"
+#include <benchmark/benchmark.h>
+#include <random>
+
+namespace {
+
+// Matches CANVAS_SCALE_UP_STEP in ScaleUpCanvas.hpp, which can't be included here since it depends on World
+const WorldScalar SCALE_UP_STEP("100000000000000000000000000000000000000000000000000");
+
+constexpr size_t SAMPLE_COUNT = 256;
+constexpr size_t BATCH_SIZE = 1024;
+
+// Magnitude of coordinates after a number of canvas scale ups
+WorldScalar magnitude_after_scale_ups(int scaleUpCount) {
+    return FixedPoint::pow_int(SCALE_UP_STEP, scaleUpCount) * WorldScalar(1000);
+}
+
+// Random scalars in the range [-magnitude, magnitude]. Generated from a fixed seed so that runs are comparable
+std::vector<WorldScalar> random_scalars(int scaleUpCount, size_t count, uint32_t seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    WorldScalar magnitude = magnitude_after_scale_ups(scaleUpCount);
+    std::vector<WorldScalar> toRet(count);
+    for(WorldScalar& s : toRet)
+        s = WorldScalar(dist(gen)) * magnitude + WorldScalar(dist(gen));
+    return toRet;
+}
+
+std::vector<WorldVec> random_world_vecs(int scaleUpCount, size_t count, uint32_t seed) {
+    std::vector<WorldScalar> xs = random_scalars(scaleUpCount, count, seed);
+    std::vector<WorldScalar> ys = random_scalars(scaleUpCount, count, seed + 1);
+    std::vector<WorldVec> toRet(count);
+    for(size_t i = 0; i < count; i++)
+        toRet[i] = WorldVec{xs[i], ys[i]};
+    return toRet;
+}
+
+std::vector<Vector2f> random_screen_points(size_t count, uint32_t seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(0.0f, 2000.0f);
+    std::vector<Vector2f> toRet(count);
+    for(Vector2f& p : toRet)
+        p = Vector2f{dist(gen), dist(gen)};
+    return toRet;
+}
+
+// A camera looking at a canvas that has been scaled up scaleUpCount times. Zoomed out far enough that the on screen
+// coordinates of points from random_world_vecs stay within a few thousand pixels
+CoordSpaceHelper camera_after_scale_ups(int scaleUpCount) {
+    std::vector<WorldScalar> p = random_scalars(scaleUpCount, 2, 1234);
+    return CoordSpaceHelper(WorldVec{p[0], p[1]}, magnitude_after_scale_ups(scaleUpCount) / WorldScalar(1000), 0.3);
+}
+
+void scale_up_args(benchmark::internal::Benchmark* b) {
+    for(int scaleUps : {0, 1, 5, 20, 50})
+        b->Arg(scaleUps);
+    b->ArgName("scaleUps");
+}
+
+template <typename F> void binary_scalar_op_benchmark(benchmark::State& state, F f) {
+    std::vector<WorldScalar> a = random_scalars(state.range(0), SAMPLE_COUNT, 1);
+    std::vector<WorldScalar> b = random_scalars(state.range(0), SAMPLE_COUNT, 2);
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(f(a[i], b[i]));
+        i = (i + 1) % SAMPLE_COUNT;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_FixedPointAdd(benchmark::State& state) {
+    binary_scalar_op_benchmark(state, [](const WorldScalar& a, const WorldScalar& b) { return a + b; });
+}
+
+void BM_FixedPointMultiply(benchmark::State& state) {
+    binary_scalar_op_benchmark(state, [](const WorldScalar& a, const WorldScalar& b) { return a * b; });
+}
+
+void BM_FixedPointDivide(benchmark::State& state) {
+    binary_scalar_op_benchmark(state, [](const WorldScalar& a, const WorldScalar& b) { return a / b; });
+}
+
+void BM_FixedPointCompare(benchmark::State& state) {
+    binary_scalar_op_benchmark(state, [](const WorldScalar& a, const WorldScalar& b) { return a < b; });
+}
+
+void BM_FixedPointShift(benchmark::State& state) {
+    binary_scalar_op_benchmark(state, [](const WorldScalar& a, const WorldScalar&) { return (a << 7) >> 3; });
+}
+
+void BM_FixedPointMultiplyDouble(benchmark::State& state) {
+    binary_scalar_op_benchmark(state, [](const WorldScalar& a, const WorldScalar&) { return a.multiply_double(1.75); });
+}
+
+void BM_FixedPointDivideDouble(benchmark::State& state) {
+    binary_scalar_op_benchmark(state, [](const WorldScalar& a, const WorldScalar&) { return a.divide_double(1.75); });
+}
+
+void BM_RotateWorldCoord(benchmark::State& state) {
+    std::vector<WorldVec> v = random_world_vecs(state.range(0), SAMPLE_COUNT, 3);
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(rotate_world_coord(v[i], 0.7));
+        i = (i + 1) % SAMPLE_COUNT;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_CoordSpaceToSpace(benchmark::State& state) {
+    CoordSpaceHelper cam = camera_after_scale_ups(state.range(0));
+    std::vector<WorldVec> v = random_world_vecs(state.range(0), SAMPLE_COUNT, 4);
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(cam.to_space(v[i]));
+        i = (i + 1) % SAMPLE_COUNT;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_CoordSpaceFromSpace(benchmark::State& state) {
+    CoordSpaceHelper cam = camera_after_scale_ups(state.range(0));
+    std::vector<Vector2f> v = random_screen_points(SAMPLE_COUNT, 5);
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(cam.from_space(v[i]));
+        i = (i + 1) % SAMPLE_COUNT;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_CoordSpaceToSpaceBatch(benchmark::State& state) {
+    CoordSpaceHelper cam = camera_after_scale_ups(state.range(0));
+    std::vector<WorldVec> v = random_world_vecs(state.range(0), BATCH_SIZE, 6);
+    std::vector<Vector2f> out(BATCH_SIZE);
+    for(auto _ : state) {
+        cam.to_space(std::span<const WorldVec>(v), std::span<Vector2f>(out));
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * BATCH_SIZE);
+}
+
+void BM_CoordSpaceFromSpaceBatch(benchmark::State& state) {
+    CoordSpaceHelper cam = camera_after_scale_ups(state.range(0));
+    std::vector<Vector2f> v = random_screen_points(BATCH_SIZE, 7);
+    std::vector<WorldVec> out(BATCH_SIZE);
+    for(auto _ : state) {
+        cam.from_space(std::span<const Vector2f>(v), std::span<WorldVec>(out));
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * BATCH_SIZE);
+}
+
+void BM_CoordSpaceOtherFromThisSpace(benchmark::State& state) {
+    CoordSpaceHelper cam = camera_after_scale_ups(state.range(0));
+    std::vector<WorldVec> v = random_world_vecs(0, SAMPLE_COUNT, 8);
+    std::vector<CoordSpaceHelper> others(SAMPLE_COUNT);
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        others[i] = CoordSpaceHelper(v[i], WorldScalar(1) << static_cast<int>(i % 16), 0.1 * static_cast<double>(i));
+    size_t i = 0;
+    for(auto _ : state) {
+        benchmark::DoNotOptimize(cam.other_coord_space_from_this_space(others[i]));
+        i = (i + 1) % SAMPLE_COUNT;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+}
+
+BENCHMARK(BM_FixedPointAdd)->Apply(scale_up_args);
+BENCHMARK(BM_FixedPointMultiply)->Apply(scale_up_args);
+BENCHMARK(BM_FixedPointDivide)->Apply(scale_up_args);
+BENCHMARK(BM_FixedPointCompare)->Apply(scale_up_args);
+BENCHMARK(BM_FixedPointShift)->Apply(scale_up_args);
+BENCHMARK(BM_FixedPointMultiplyDouble)->Apply(scale_up_args);
+BENCHMARK(BM_FixedPointDivideDouble)->Apply(scale_up_args);
+BENCHMARK(BM_RotateWorldCoord)->Apply(scale_up_args);
+BENCHMARK(BM_CoordSpaceToSpace)->Apply(scale_up_args);
+BENCHMARK(BM_CoordSpaceFromSpace)->Apply(scale_up_args);
+BENCHMARK(BM_CoordSpaceToSpaceBatch)->Apply(scale_up_args);
+BENCHMARK(BM_CoordSpaceFromSpaceBatch)->Apply(scale_up_args);
+BENCHMARK(BM_CoordSpaceOtherFromThisSpace)->Apply(scale_up_args);
+
+BENCHMARK_MAIN();
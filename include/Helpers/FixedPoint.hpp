@@ -18,6 +18,7 @@
 
 #pragma once
 #include "Helpers/StringHelpers.hpp"
+#include "Helpers/HybridInt.hpp"
 #include <cmath>
 #include <cstdint>
 #include <string>
@@ -33,7 +34,7 @@ namespace FixedPoint {
     }
 
     template <typename T> T sqrt(const T& a) {
-        return T(boost::multiprecision::sqrt(a.get_underlying_val() << a.bit_fraction_count()), true);
+        return T(integer_sqrt(a.get_underlying_val() << a.bit_fraction_count()), true);
     }
 
     template <typename T> T lerp(const T& a, const T& b, const T& t) {
@@ -124,11 +125,15 @@ namespace FixedPoint {
     }
 
     template <typename T> T pow_int(const T& x, uint64_t exp) {
-        if(exp == 0)
-            return T(1);
-        T toRet = x;
-        for(uint64_t i = 1; i < exp; i++)
-            toRet *= toRet;
+        T toRet(1);
+        T base = x;
+        while(exp != 0) {
+            if(exp & 1)
+                toRet *= base;
+            exp >>= 1;
+            if(exp != 0)
+                base *= base;
+        }
         return toRet;
     }
 
@@ -242,20 +247,33 @@ namespace FixedPoint {
             }
     
             template <typename Archive> void load(Archive& a) {
-                bool isNegative;
-                std::vector<uint8_t> v;
-                a(isNegative, v);
-                boost::multiprecision::import_bits(val, v.begin(), v.end(), 8, true);
-                if(isNegative)
-                    val = -val;
+                uint8_t firstByte;
+                a(firstByte);
+                if(firstByte <= 1) {
+                    // Saved by older versions, as a sign bool followed by a byte vector
+                    std::vector<uint8_t> v;
+                    a(v);
+                    boost::multiprecision::cpp_int bigVal;
+                    boost::multiprecision::import_bits(bigVal, v.begin(), v.end(), 8, true);
+                    if(firstByte)
+                        bigVal = -bigVal;
+                    val = T(bigVal);
+                }
+                else {
+                    HybridInt hybridVal;
+                    hybridVal.load_varint(a, firstByte);
+                    if constexpr(std::is_same_v<T, HybridInt>)
+                        val = std::move(hybridVal);
+                    else
+                        val = T(hybridVal.to_big_int());
+                }
             }
     
             template <typename Archive> void save(Archive& a) const {
-                bool isNegative = val < 0;
-                std::vector<uint8_t> v;
-                T absVal = boost::multiprecision::abs(val);
-                boost::multiprecision::export_bits(absVal, std::back_inserter(v), 8, true);
-                a(isNegative, v);
+                if constexpr(std::is_same_v<T, HybridInt>)
+                    val.save_varint(a);
+                else
+                    HybridInt(to_big_int(val)).save_varint(a);
             }
     
             Number operator-(const Number& other) const {
@@ -651,8 +669,8 @@ namespace FixedPoint {
     }
 }
 
-typedef FixedPoint::Number<boost::multiprecision::cpp_int, 32> WorldScalar;
-typedef FixedPoint::Multiplier<boost::multiprecision::cpp_int, 32> WorldMultiplier;
+typedef FixedPoint::Number<FixedPoint::HybridInt, 32> WorldScalar;
+typedef FixedPoint::Multiplier<FixedPoint::HybridInt, 32> WorldMultiplier;
 
 namespace Eigen {
   template<> struct NumTraits<WorldScalar> : GenericNumTraits<WorldScalar>
@@ -0,0 +1,432 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <cmath>
+#include <array>
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/multiprecision/cpp_int.hpp>
+#include <cereal/cereal.hpp>
+
+namespace FixedPoint {
+    // Integer that is stored inline as a fixed width integer, and only promotes itself to a heap allocated cpp_int when a result doesn't fit.
+    // Results that fit in the inline integer again are demoted back, so the fast path is taken whenever possible.
+    // Behaves like cpp_int for every operation used by FixedPoint::Number (truncating division, arithmetic right shift, saturating conversions)
+    class HybridInt {
+        public:
+#if defined(__SIZEOF_INT128__)
+            typedef __int128 SmallType;
+            typedef unsigned __int128 SmallUnsignedType;
+#else
+            typedef int64_t SmallType; // MSVC has no 128 bit integer, overflow will just promote more often
+            typedef uint64_t SmallUnsignedType;
+#endif
+            typedef boost::multiprecision::cpp_int BigType;
+
+            static constexpr int SMALL_BITS = sizeof(SmallType) * 8;
+            static constexpr SmallType SMALL_MAX = std::numeric_limits<SmallType>::max();
+            static constexpr SmallType SMALL_MIN = std::numeric_limits<SmallType>::min();
+
+            HybridInt():
+                small(0) {}
+
+            template <std::signed_integral I> HybridInt(I initVal):
+                small(0)
+            {
+                if constexpr(sizeof(I) <= sizeof(SmallType))
+                    small = initVal;
+                else
+                    set_big(BigType(initVal));
+            }
+
+            template <std::unsigned_integral I> HybridInt(I initVal):
+                small(0)
+            {
+                if constexpr(sizeof(I) < sizeof(SmallType))
+                    small = initVal;
+                else if(initVal <= static_cast<I>(SMALL_MAX))
+                    small = static_cast<SmallType>(initVal);
+                else
+                    set_big(BigType(initVal));
+            }
+
+            explicit HybridInt(double initVal):
+                small(0)
+            {
+                // Bounds are exact powers of two, so anything strictly inside them is safe to truncate directly
+                constexpr double SMALL_LIMIT = static_cast<double>(SMALL_MAX) + 1.0;
+                if(initVal < SMALL_LIMIT && initVal > -SMALL_LIMIT)
+                    small = static_cast<SmallType>(initVal);
+                else
+                    set_big(BigType(initVal));
+            }
+
+            explicit HybridInt(float initVal):
+                HybridInt(static_cast<double>(initVal)) {}
+
+            explicit HybridInt(const std::string& initVal):
+                small(0)
+            {
+                set_big(BigType(initVal));
+            }
+
+            explicit HybridInt(const BigType& initVal):
+                small(0)
+            {
+                set_big(initVal);
+            }
+
+            HybridInt(const HybridInt& other):
+                small(other.small),
+                big(other.big ? std::make_unique<BigType>(*other.big) : nullptr)
+            {}
+
+            HybridInt(HybridInt&& other) noexcept = default;
+
+            HybridInt& operator=(const HybridInt& other) {
+                if(this != &other) {
+                    small = other.small;
+                    if(!other.big)
+                        big.reset();
+                    else if(big)
+                        *big = *other.big;
+                    else
+                        big = std::make_unique<BigType>(*other.big);
+                }
+                return *this;
+            }
+
+            HybridInt& operator=(HybridInt&& other) noexcept = default;
+
+            bool is_small() const {
+                return !big;
+            }
+
+            // Serialized as a zig-zag varint (7 bits per byte, least significant group first). The zig-zag value is offset by VARINT_OFFSET,
+            // so that the first byte is never 0 or 1. This lets readers tell it apart from the older format, which started with a sign bool
+            static constexpr int VARINT_OFFSET = 2;
+            static constexpr int VARINT_MAX_BITS = 1 << 20; // Anything longer is treated as corrupt data
+
+            template <typename Archive> void save_varint(Archive& a) const {
+                std::array<uint8_t, SMALL_BITS / 7 + 2> buf;
+                size_t bufSize = 0;
+                if(!big && small > (SMALL_MIN >> 2) && small < (SMALL_MAX >> 2)) {
+                    SmallUnsignedType zz = (small < 0 ? ((static_cast<SmallUnsignedType>(-small) << 1) - 1) : (static_cast<SmallUnsignedType>(small) << 1)) + VARINT_OFFSET;
+                    while(zz >= 0x80) {
+                        buf[bufSize++] = static_cast<uint8_t>(zz & 0x7F) | 0x80;
+                        zz >>= 7;
+                    }
+                    buf[bufSize++] = static_cast<uint8_t>(zz);
+                    a(cereal::binary_data(buf.data(), bufSize));
+                    return;
+                }
+                BigType v = to_big_int();
+                BigType zz = (v < 0 ? ((BigType(-v) << 1) - 1) : (v << 1)) + VARINT_OFFSET;
+                std::vector<uint8_t> bigBuf;
+                while(zz >= 0x80) {
+                    bigBuf.emplace_back(static_cast<uint8_t>(static_cast<unsigned>(zz & 0x7F)) | 0x80);
+                    zz >>= 7;
+                }
+                bigBuf.emplace_back(static_cast<uint8_t>(static_cast<unsigned>(zz)));
+                a(cereal::binary_data(bigBuf.data(), bigBuf.size()));
+            }
+
+            template <typename Archive> void load_varint(Archive& a, uint8_t firstByte) {
+                SmallUnsignedType zz = 0;
+                std::unique_ptr<BigType> bigZZ;
+                uint8_t b = firstByte;
+                for(int shift = 0;; shift += 7) {
+                    if(shift > VARINT_MAX_BITS)
+                        throw std::runtime_error("[HybridInt::load_varint] Varint too long");
+                    if(!bigZZ && shift > SMALL_BITS - 8)
+                        bigZZ = std::make_unique<BigType>(zz);
+                    if(bigZZ)
+                        *bigZZ |= BigType(b & 0x7F) << shift;
+                    else
+                        zz |= static_cast<SmallUnsignedType>(b & 0x7F) << shift;
+                    if(!(b & 0x80))
+                        break;
+                    a(b);
+                }
+                if(!bigZZ) {
+                    zz -= VARINT_OFFSET;
+                    SmallType v = static_cast<SmallType>(zz >> 1);
+                    big.reset();
+                    small = (zz & 1) ? (-v - 1) : v;
+                }
+                else {
+                    *bigZZ -= VARINT_OFFSET;
+                    BigType v = *bigZZ >> 1;
+                    set_big(bit_test(*bigZZ, 0) ? BigType(-v - 1) : v);
+                }
+            }
+
+            BigType to_big_int() const {
+                if(big)
+                    return *big;
+                return BigType(small);
+            }
+
+            std::string str() const {
+                if(big)
+                    return big->str();
+                if(small == 0)
+                    return "0";
+                std::string toRet;
+                bool isNegative = small < 0;
+                SmallType a = small;
+                while(a != 0) {
+                    int digit = static_cast<int>(a % 10);
+                    toRet.push_back(static_cast<char>('0' + (isNegative ? -digit : digit)));
+                    a /= 10;
+                }
+                if(isNegative)
+                    toRet.push_back('-');
+                return std::string(toRet.rbegin(), toRet.rend());
+            }
+
+            explicit operator bool() const {
+                return big ? !big->is_zero() : small != 0;
+            }
+
+            template <std::integral I> requires (!std::same_as<I, bool>) explicit operator I() const {
+                if(!big && small_fits_in<I>())
+                    return static_cast<I>(small);
+                // Out of range conversions follow cpp_int (saturate, throw on negative to unsigned)
+                return to_big_int().template convert_to<I>();
+            }
+
+            explicit operator double() const {
+                if(big)
+                    return big->convert_to<double>();
+                return static_cast<double>(small);
+            }
+
+            explicit operator float() const {
+                if(big)
+                    return big->convert_to<float>();
+                return static_cast<float>(small);
+            }
+
+            HybridInt operator-() const {
+                if(!big && small != SMALL_MIN)
+                    return HybridInt(-small, SmallTag{});
+                return from_big(-to_big_int());
+            }
+
+            friend HybridInt operator+(const HybridInt& a, const HybridInt& b) {
+                SmallType r;
+                if(!a.big && !b.big && !add_overflow(a.small, b.small, r))
+                    return HybridInt(r, SmallTag{});
+                return from_big(a.to_big_int() + b.to_big_int());
+            }
+
+            friend HybridInt operator-(const HybridInt& a, const HybridInt& b) {
+                SmallType r;
+                if(!a.big && !b.big && !sub_overflow(a.small, b.small, r))
+                    return HybridInt(r, SmallTag{});
+                return from_big(a.to_big_int() - b.to_big_int());
+            }
+
+            friend HybridInt operator*(const HybridInt& a, const HybridInt& b) {
+                SmallType r;
+                if(!a.big && !b.big && !mul_overflow(a.small, b.small, r))
+                    return HybridInt(r, SmallTag{});
+                return from_big(a.to_big_int() * b.to_big_int());
+            }
+
+            friend HybridInt operator/(const HybridInt& a, const HybridInt& b) {
+                if(!a.big && !b.big) {
+                    if(b.small == 0)
+                        throw std::overflow_error("Division by zero.");
+                    if(!(a.small == SMALL_MIN && b.small == -1))
+                        return HybridInt(a.small / b.small, SmallTag{});
+                }
+                return from_big(a.to_big_int() / b.to_big_int());
+            }
+
+            friend HybridInt operator%(const HybridInt& a, const HybridInt& b) {
+                if(!a.big && !b.big) {
+                    if(b.small == 0)
+                        throw std::overflow_error("Division by zero.");
+                    if(b.small == -1)
+                        return HybridInt();
+                    return HybridInt(a.small % b.small, SmallTag{});
+                }
+                return from_big(a.to_big_int() % b.to_big_int());
+            }
+
+            HybridInt operator<<(int shiftNum) const {
+                if(!big) {
+                    if(small == 0)
+                        return HybridInt();
+                    if(shiftNum < SMALL_BITS - 1 && small >= (SMALL_MIN >> shiftNum) && small <= (SMALL_MAX >> shiftNum))
+                        return HybridInt(small << shiftNum, SmallTag{}); // Safe, value is known to fit after shifting
+                }
+                return from_big(to_big_int() << shiftNum);
+            }
+
+            HybridInt operator>>(int shiftNum) const {
+                if(!big) {
+                    if(shiftNum >= SMALL_BITS)
+                        return HybridInt(small < 0 ? -1 : 0, SmallTag{});
+                    return HybridInt(small >> shiftNum, SmallTag{});
+                }
+                return from_big(*big >> shiftNum);
+            }
+
+            HybridInt& operator+=(const HybridInt& other) { return *this = *this + other; }
+            HybridInt& operator-=(const HybridInt& other) { return *this = *this - other; }
+            HybridInt& operator*=(const HybridInt& other) { return *this = *this * other; }
+            HybridInt& operator/=(const HybridInt& other) { return *this = *this / other; }
+            HybridInt& operator%=(const HybridInt& other) { return *this = *this % other; }
+            HybridInt& operator<<=(int shiftNum) { return *this = *this << shiftNum; }
+            HybridInt& operator>>=(int shiftNum) { return *this = *this >> shiftNum; }
+
+            HybridInt integer_sqrt() const {
+                if(!big && small >= 0 && small <= static_cast<SmallType>(std::numeric_limits<int64_t>::max() >> 1)) {
+                    // Correct the floating point estimate so the result matches the exact integer square root
+                    SmallType r = static_cast<SmallType>(std::sqrt(static_cast<double>(small)));
+                    while(r > 0 && r * r > small)
+                        r--;
+                    while((r + 1) * (r + 1) <= small)
+                        r++;
+                    return HybridInt(r, SmallTag{});
+                }
+                return from_big(boost::multiprecision::sqrt(to_big_int()));
+            }
+
+            friend bool operator==(const HybridInt& a, const HybridInt& b) {
+                // Values are always normalized, so a big number can never equal a small one
+                if(!a.big && !b.big)
+                    return a.small == b.small;
+                if(a.big && b.big)
+                    return *a.big == *b.big;
+                return false;
+            }
+
+            friend std::strong_ordering operator<=>(const HybridInt& a, const HybridInt& b) {
+                if(!a.big && !b.big)
+                    return a.small <=> b.small;
+                int c = a.to_big_int().compare(b.to_big_int());
+                return c < 0 ? std::strong_ordering::less : (c > 0 ? std::strong_ordering::greater : std::strong_ordering::equal);
+            }
+
+        private:
+            struct SmallTag {};
+
+            HybridInt(SmallType initVal, SmallTag):
+                small(initVal) {}
+
+            template <std::integral I> bool small_fits_in() const {
+                if constexpr(std::is_unsigned_v<I> && sizeof(I) >= sizeof(SmallType))
+                    return small >= 0;
+                else if constexpr(sizeof(I) >= sizeof(SmallType))
+                    return true;
+                else
+                    return small >= static_cast<SmallType>(std::numeric_limits<I>::min()) && small <= static_cast<SmallType>(std::numeric_limits<I>::max());
+            }
+
+            static HybridInt from_big(const BigType& a) {
+                HybridInt toRet;
+                toRet.set_big(a);
+                return toRet;
+            }
+
+            void set_big(const BigType& a) {
+                if(a >= SMALL_MIN_BIG() && a <= SMALL_MAX_BIG()) {
+                    small = a.convert_to<SmallType>();
+                    big.reset();
+                }
+                else
+                    big = std::make_unique<BigType>(a);
+            }
+
+            static const BigType& SMALL_MIN_BIG() {
+                static const BigType v(SMALL_MIN);
+                return v;
+            }
+
+            static const BigType& SMALL_MAX_BIG() {
+                static const BigType v(SMALL_MAX);
+                return v;
+            }
+
+            static bool add_overflow(SmallType a, SmallType b, SmallType& r) {
+#if defined(__GNUC__) || defined(__clang__)
+                return __builtin_add_overflow(a, b, &r);
+#else
+                if((b > 0 && a > SMALL_MAX - b) || (b < 0 && a < SMALL_MIN - b))
+                    return true;
+                r = a + b;
+                return false;
+#endif
+            }
+
+            static bool sub_overflow(SmallType a, SmallType b, SmallType& r) {
+#if defined(__GNUC__) || defined(__clang__)
+                return __builtin_sub_overflow(a, b, &r);
+#else
+                if((b < 0 && a > SMALL_MAX + b) || (b > 0 && a < SMALL_MIN + b))
+                    return true;
+                r = a - b;
+                return false;
+#endif
+            }
+
+            static bool mul_overflow(SmallType a, SmallType b, SmallType& r) {
+#if defined(__GNUC__) || defined(__clang__)
+                return __builtin_mul_overflow(a, b, &r);
+#else
+                if(a != 0 && b != 0) {
+                    if(a > 0 ? (b > 0 ? a > SMALL_MAX / b : b < SMALL_MIN / a)
+                             : (b > 0 ? a < SMALL_MIN / b : a < SMALL_MAX / b))
+                        return true;
+                }
+                r = a * b;
+                return false;
+#endif
+            }
+
+            SmallType small;
+            std::unique_ptr<BigType> big; // Only set when the value doesn't fit in small
+    };
+
+    inline HybridInt::BigType to_big_int(const HybridInt& a) {
+        return a.to_big_int();
+    }
+
+    inline const boost::multiprecision::cpp_int& to_big_int(const boost::multiprecision::cpp_int& a) {
+        return a;
+    }
+
+    inline HybridInt integer_sqrt(const HybridInt& a) {
+        return a.integer_sqrt();
+    }
+
+    inline boost::multiprecision::cpp_int integer_sqrt(const boost::multiprecision::cpp_int& a) {
+        return boost::multiprecision::sqrt(a);
+    }
+}
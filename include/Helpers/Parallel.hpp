@@ -17,13 +17,15 @@
  */
 
 #pragma once
+#include <algorithm>
 #include <execution>
 #ifdef __APPLE__
     #define POOLSTL_STD_SUPPLEMENT
     #include <poolstl.hpp>
 #endif
 
-template <typename ContainerType> void parallel_loop_container(const ContainerType& c, std::function<void(const typename ContainerType::value_type&)> func, bool forceSingleThread = false) {
+// The function is a template parameter rather than a std::function, so that it can be inlined into the loop
+template <typename ContainerType, typename F> void parallel_loop_container(const ContainerType& c, F&& func, bool forceSingleThread = false) {
 #if defined(__EMSCRIPTEN__) || defined(__ANDROID__)
     std::for_each(c.begin(), c.end(), func);
 #else
@@ -34,7 +36,7 @@ template <typename ContainerType> void parallel_loop_container(const ContainerTy
 #endif
 }
 
-template <typename ContainerType> void parallel_loop_container_mutable(ContainerType& c, std::function<void(typename ContainerType::value_type&)> func, bool forceSingleThread = false) {
+template <typename ContainerType, typename F> void parallel_loop_container_mutable(ContainerType& c, F&& func, bool forceSingleThread = false) {
 #if defined(__EMSCRIPTEN__) || defined(__ANDROID__)
     std::for_each(c.begin(), c.end(), func);
 #else
@@ -71,6 +71,10 @@ bool CanvasComponent::should_draw_extra(const DrawData& drawData, const CoordSpa
     return true;
 }
 
+std::optional<SCollision::AABB<float>> CanvasComponent::get_opaque_obj_coord_bounds(const DrawData& drawData) const {
+    return std::nullopt;
+}
+
 bool CanvasComponent::can_erase_detail() const {
     return false;
 }
@@ -67,6 +67,9 @@ class CanvasComponent {
         virtual CanvasComponentEraseDetailResult erase_detail(const SkPath& eraseAgainst);
 
         virtual SCollision::AABB<float> get_obj_coord_bounds() const = 0;
+        // Area in object coordinates that's completely covered by opaque pixels when drawn, if there is one. Components fully
+        // under it are skipped while drawing, so it must never be larger than the opaque area
+        virtual std::optional<SCollision::AABB<float>> get_opaque_obj_coord_bounds(const DrawData& drawData) const;
 
         CanvasComponentContainer* compContainer = nullptr;
 };
@@ -22,9 +22,11 @@
 #include "../DrawingProgram/DrawingProgram.hpp"
 #include "../World.hpp"
 #include "CanvasComponent.hpp"
+#include "MeshCanvasComponent.hpp"
 #include <Helpers/NetworkingObjects/DelayUpdateSerializedClassManager.hpp>
 #include <include/core/SkScalar.h>
 #include "../ScaleUpCanvas.hpp"
+#include "../RenderStats.hpp"
 #include "Helpers/NetworkingObjects/NetObjManager.hpp"
 
 using namespace NetworkingObjects;
@@ -122,6 +124,7 @@ void CanvasComponentContainer::draw(SkCanvas* canvas, const DrawData& drawData)
 }
 
 void CanvasComponentContainer::draw_with_predraw_data(SkCanvas* canvas, const DrawData& drawData, const PreDrawData& preDrawData) const {
+    RenderStats::current().componentsDrawn++;
     if(preDrawData.transformData.scale < COMP_MAX_BEFORE_STOP_SCALING || !get_comp().accurate_draw(canvas, drawData, coords, preDrawData.extraData)) {
         canvas->save();
         canvas_do_transform(canvas, preDrawData.transformData);
@@ -130,6 +133,17 @@ void CanvasComponentContainer::draw_with_predraw_data(SkCanvas* canvas, const Dr
     }
 }
 
+void CanvasComponentContainer::draw_components_with_predraw_data(SkCanvas* canvas, const DrawData& drawData, std::span<ObjInfo* const> comps) {
+    for(size_t i = 0; i < comps.size();) {
+        size_t drawnCount = MeshCanvasComponent::draw_batch(canvas, drawData, comps.subspan(i));
+        if(drawnCount == 0) {
+            comps[i]->obj->draw_with_predraw_data(canvas, drawData, comps[i]->obj->preDrawDataHolder.value());
+            drawnCount = 1;
+        }
+        i += drawnCount;
+    }
+}
+
 void CanvasComponentContainer::commit_update(DrawingProgram& drawP) {
     drawP.preupdate_component(&(*objInfo));
     get_comp().initialize_draw_data(drawP);
@@ -166,7 +180,7 @@ CanvasComponentEraseDetailResult CanvasComponentContainer::collides_with_erase_d
         return CanvasComponentEraseDetailResult::NO_CHANGE;
     }
     else if(get_comp().can_erase_detail()) {
-        TransformData drawTransform = calculate_draw_transform(camCoords, coords);
+        TransformData drawTransform = ComponentDrawTransform::calculate_draw_transform(camCoords, coords);
         SkMatrix m = SkMatrix::I();
         m.postScale(1.0 / drawTransform.scale, 1.0 / drawTransform.scale).postRotate(-drawTransform.rotation).postTranslate(-drawTransform.translation.x(), -drawTransform.translation.y());
         std::optional<SkPath> transformedPath = checkAgainstCam.tryMakeTransform(m);
@@ -185,7 +199,7 @@ bool CanvasComponentContainer::collides_with(const CoordSpaceHelper& camCoords,
     else if(coords.inverseScale < (camCoords.inverseScale >> COMP_COLLIDE_MIN_SHIFT_TINY))
         return checkAgainstCam.contains(convert_vec2<SkPoint>(camCoords.to_space(worldAABB.value().min)));
     else {
-        TransformData drawTransform = calculate_draw_transform(camCoords, coords);
+        TransformData drawTransform = ComponentDrawTransform::calculate_draw_transform(camCoords, coords);
         SkMatrix m = SkMatrix::I();
         m.postScale(1.0 / drawTransform.scale, 1.0 / drawTransform.scale).postRotate(-drawTransform.rotation).postTranslate(-drawTransform.translation.x(), -drawTransform.translation.y());
         std::optional<SkPath> transformedPath = checkAgainstCam.tryMakeTransform(m);
@@ -203,7 +217,7 @@ bool CanvasComponentContainer::collides_with_point(const CoordSpaceHelper& camCo
     else if(coords.inverseScale < (camCoords.inverseScale >> COMP_COLLIDE_MIN_SHIFT_TINY)) // Object is too tiny, just dismiss the collision
         return false;
     else {
-        TransformData drawTransform = calculate_draw_transform(camCoords, coords);
+        TransformData drawTransform = ComponentDrawTransform::calculate_draw_transform(camCoords, coords);
         SkMatrix m = SkMatrix::I();
         m.postScale(1.0 / drawTransform.scale, 1.0 / drawTransform.scale).postRotate(-drawTransform.rotation).postTranslate(-drawTransform.translation.x(), -drawTransform.translation.y());
         SkPoint p = m.mapPoint(convert_vec2<SkPoint>(checkAgainstCam));
@@ -222,8 +236,15 @@ bool CanvasComponentContainer::should_draw(const DrawData& drawData) const {
 }
 
 CanvasComponentContainer::PreDrawData CanvasComponentContainer::calculate_predraw_data(const DrawData& drawData) const {
+    return calculate_predraw_data(drawData, std::nullopt);
+}
+
+CanvasComponentContainer::PreDrawData CanvasComponentContainer::calculate_predraw_data(const DrawData& drawData, const std::optional<CameraRelativeNodeOrigin>& nodeOrigin) const {
     PreDrawData toRet;
-    toRet.transformData = calculate_draw_transform(drawData.cam.c, coords);
+    std::optional<TransformData> nodeTransform;
+    if(nodeOrigin.has_value() && !cacheParentBvhNode.expired())
+        nodeTransform = ComponentDrawTransform::calculate_draw_transform_from_node(nodeOrigin.value(), cacheParentBvhNodeRelativeCoords, drawData.cam.c.rotation, coords.rotation);
+    toRet.transformData = nodeTransform.has_value() ? nodeTransform.value() : ComponentDrawTransform::calculate_draw_transform(drawData.cam.c, coords);
     if(toRet.transformData.scale < COMP_MAX_BEFORE_STOP_SCALING)
         toRet.extraData = get_comp().get_predraw_data(drawData);
     else
@@ -231,14 +252,6 @@ CanvasComponentContainer::PreDrawData CanvasComponentContainer::calculate_predra
     return toRet;
 }
 
-CanvasComponentContainer::TransformData CanvasComponentContainer::calculate_draw_transform(const CoordSpaceHelper& camCoords, const CoordSpaceHelper& coords) {
-    TransformData toRet;
-    toRet.translation = -coords.to_space(camCoords.pos);
-    toRet.rotation = (coords.rotation - camCoords.rotation) * 180.0 / std::numbers::pi;
-    toRet.scale = std::min(static_cast<float>(coords.inverseScale / camCoords.inverseScale), COMP_MAX_BEFORE_STOP_SCALING);
-    return toRet;
-}
-
 void CanvasComponentContainer::scale_up(const WorldScalar& scaleUpAmount) {
     coords.scale_about(WorldVec{0, 0}, scaleUpAmount, true);
     calculate_world_bounds();
@@ -255,6 +268,21 @@ const std::optional<SCollision::AABB<WorldScalar>>& CanvasComponentContainer::ge
     return worldAABB;
 }
 
+std::optional<SCollision::AABB<WorldScalar>> CanvasComponentContainer::get_opaque_world_bounds(const DrawData& drawData) const {
+    if(coords.rotation != 0.0) // The world bounds of a rotated rectangle cover more than the rectangle
+        return std::nullopt;
+    std::optional<SCollision::AABB<float>> opaqueBounds = get_comp().get_opaque_obj_coord_bounds(drawData);
+    if(!opaqueBounds.has_value())
+        return std::nullopt;
+    // Pixels on the edge are only partially covered, so leave two pixels out on each side
+    WorldScalar edgeSize = drawData.cam.c.inverseScale << 1;
+    WorldVec opaqueMin = coords.from_space(opaqueBounds.value().min) + WorldVec{edgeSize, edgeSize};
+    WorldVec opaqueMax = coords.from_space(opaqueBounds.value().max) - WorldVec{edgeSize, edgeSize};
+    if(opaqueMin.x() >= opaqueMax.x() || opaqueMin.y() >= opaqueMax.y())
+        return std::nullopt;
+    return SCollision::AABB<WorldScalar>(opaqueMin, opaqueMax);
+}
+
 CanvasComponent& CanvasComponentContainer::get_comp() const {
     return *compAllocator->comp;
 }
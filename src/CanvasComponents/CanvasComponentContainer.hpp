@@ -18,6 +18,7 @@
 
 #pragma once
 #include "../CoordSpaceHelper.hpp"
+#include "ComponentDrawTransform.hpp"
 #include <Helpers/NetworkingObjects/NetObjManagerTypeList.hpp>
 #include "CanvasComponentType.hpp"
 #include "../VersionConstants.hpp"
@@ -25,6 +26,7 @@
 #include <Helpers/NetworkingObjects/NetObjOwnerPtr.hpp>
 #include "CanvasComponentAllocator.hpp"
 #include "../WorldUndoManager.hpp"
+#include <span>
 
 class DrawingProgram;
 class DrawingProgramLayerListItem;
@@ -45,8 +47,8 @@ class CanvasComponentContainer {
         typedef NetworkingObjects::NetObjOrderedListIterator<CanvasComponentContainer> ObjInfoIterator;
 
         constexpr static int COMP_MAX_SHIFT_BEFORE_STOP_COLLISIONS = 14;
-        constexpr static int COMP_MAX_SHIFT_BEFORE_STOP_SCALING = 14;
-        constexpr static float COMP_MAX_BEFORE_STOP_SCALING = 1 << COMP_MAX_SHIFT_BEFORE_STOP_SCALING;
+        constexpr static int COMP_MAX_SHIFT_BEFORE_STOP_SCALING = ComponentDrawTransform::MAX_SHIFT_BEFORE_STOP_SCALING;
+        constexpr static float COMP_MAX_BEFORE_STOP_SCALING = ComponentDrawTransform::MAX_BEFORE_STOP_SCALING;
         constexpr static int COMP_MIN_SHIFT_BEFORE_DISAPPEAR = 11;
         constexpr static int COMP_COLLIDE_MIN_SHIFT_TINY = 9;
         constexpr static int COMP_MIPMAP_LEVEL_ONE = 2;
@@ -58,16 +60,15 @@ class CanvasComponentContainer {
             void scale_up(const WorldScalar& scaleUpAmount);
         };
 
-        struct TransformData {
-            Vector2f translation;
-            float rotation;
-            float scale;
-        };
+        typedef ComponentDrawTransform::TransformData TransformData;
         struct PreDrawData {
             TransformData transformData;
             std::shared_ptr<void> extraData;
         };
         std::optional<PreDrawData> preDrawDataHolder; // Can be used to store transforms when calculating transforms in parallel (and other predraw data)
+
+        typedef ComponentDrawTransform::NodeRelativeCoords NodeRelativeCoords;
+        typedef ComponentDrawTransform::CameraRelativeNodeOrigin CameraRelativeNodeOrigin;
         
         CanvasComponentContainer();
         CanvasComponentContainer(NetworkingObjects::NetObjManager& objMan, CanvasComponentType type);
@@ -80,10 +81,14 @@ class CanvasComponentContainer {
         void load_file(cereal::PortableBinaryInputArchive& a, VersionNumber version, NetworkingObjects::NetObjManager& objMan);
         CanvasComponent& get_comp() const;
         const std::optional<SCollision::AABB<WorldScalar>>& get_world_bounds() const;
+        // Conservative world space area covered by the component's opaque pixels, shrunk by the antialiased edge when drawn with drawData
+        std::optional<SCollision::AABB<WorldScalar>> get_opaque_world_bounds(const DrawData& drawData) const;
         void draw(SkCanvas* canvas, const DrawData& drawData) const;
         void draw_with_predraw_data(SkCanvas* canvas, const DrawData& drawData, const PreDrawData& preDrawData) const;
+        // Draws the components in order with their preDrawDataHolder, merging components that can be drawn together into one draw
+        static void draw_components_with_predraw_data(SkCanvas* canvas, const DrawData& drawData, std::span<ObjInfo* const> comps);
         PreDrawData calculate_predraw_data(const DrawData& drawData) const;
-        static TransformData calculate_draw_transform(const CoordSpaceHelper& camCoords, const CoordSpaceHelper& coords);
+        PreDrawData calculate_predraw_data(const DrawData& drawData, const std::optional<CameraRelativeNodeOrigin>& nodeOrigin) const;
         static void canvas_do_transform(SkCanvas* canvas, const TransformData& transformData);
         void commit_update(DrawingProgram& drawP);
         void commit_transform_dont_invalidate_cache(); // Must be thread safe
@@ -99,6 +104,7 @@ class CanvasComponentContainer {
         void set_object_update_lock(DrawingProgram& drawP, bool lockSet);
 
         std::weak_ptr<DrawingProgramCacheBVHNode> cacheParentBvhNode;
+        NodeRelativeCoords cacheParentBvhNodeRelativeCoords; // Only valid while cacheParentBvhNode is set
         DrawingProgramLayerListItem* parentLayer = nullptr;
         CoordSpaceHelper coords;
         ObjInfoIterator objInfo;
@@ -0,0 +1,70 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ComponentDrawTransform.hpp"
+#include <numbers>
+
+namespace ComponentDrawTransform {
+
+TransformData calculate_draw_transform(const CoordSpaceHelper& camCoords, const CoordSpaceHelper& coords) {
+    TransformData toRet;
+    toRet.translation = -coords.to_space(camCoords.pos);
+    toRet.rotation = (coords.rotation - camCoords.rotation) * 180.0 / std::numbers::pi;
+    toRet.scale = std::min(static_cast<float>(coords.inverseScale / camCoords.inverseScale), MAX_BEFORE_STOP_SCALING);
+    return toRet;
+}
+
+// Divides two positive world scalars while keeping precision when the result is less than 1
+static double world_scalar_ratio(const WorldScalar& a, const WorldScalar& b) {
+    if(a >= b)
+        return static_cast<double>(a / b);
+    return 1.0 / static_cast<double>(b / a);
+}
+
+std::optional<TransformData> calculate_draw_transform_from_node(const CameraRelativeNodeOrigin& nodeOrigin, const NodeRelativeCoords& relativeCoords, double camRotation, double rotation) {
+    // Same result as calculate_draw_transform, with (coords.pos - camCoords.pos) / camCoords.inverseScale split into the node's offset from the camera and the component's offset from the node
+    double scale = relativeCoords.inverseScale * nodeOrigin.inverseScale;
+    if(scale >= MAX_BEFORE_STOP_SCALING) // Object is drawn accurately at this scale, which requires the exact path
+        return std::nullopt;
+    Vector2d camSpaceOffset = nodeOrigin.pos + relativeCoords.pos * nodeOrigin.inverseScale;
+    TransformData toRet;
+    toRet.translation = (Rotation2D<double>(-rotation) * (camSpaceOffset / scale)).cast<float>();
+    toRet.rotation = (rotation - camRotation) * 180.0 / std::numbers::pi;
+    toRet.scale = static_cast<float>(scale);
+    return toRet;
+}
+
+NodeRelativeCoords calculate_node_relative_coords(const CoordSpaceHelper& nodeCoords, const CoordSpaceHelper& coords) {
+    // Node coords are never rotated
+    NodeRelativeCoords toRet;
+    toRet.pos = ((coords.pos - nodeCoords.pos) / nodeCoords.inverseScale).cast<double>();
+    toRet.inverseScale = world_scalar_ratio(coords.inverseScale, nodeCoords.inverseScale);
+    return toRet;
+}
+
+std::optional<CameraRelativeNodeOrigin> calculate_camera_relative_node_origin(const CoordSpaceHelper& camCoords, const CoordSpaceHelper& nodeCoords) {
+    // Past this zoom level, double precision in node space isn't enough to place components exactly on screen
+    if((camCoords.inverseScale << MAX_SHIFT_BEFORE_STOP_SCALING) < nodeCoords.inverseScale)
+        return std::nullopt;
+    CameraRelativeNodeOrigin toRet;
+    toRet.pos = ((nodeCoords.pos - camCoords.pos) / camCoords.inverseScale).cast<double>();
+    toRet.inverseScale = world_scalar_ratio(nodeCoords.inverseScale, camCoords.inverseScale);
+    return toRet;
+}
+
+}
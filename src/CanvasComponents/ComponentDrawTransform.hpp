@@ -0,0 +1,52 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "../CoordSpaceHelper.hpp"
+#include <optional>
+
+// Transforms used to draw a canvas component in camera space. Kept apart from CanvasComponentContainer so that the double precision
+// path through the cache tree nodes can be checked against the exact WorldScalar path without a World
+namespace ComponentDrawTransform {
+    constexpr int MAX_SHIFT_BEFORE_STOP_SCALING = 14;
+    constexpr float MAX_BEFORE_STOP_SCALING = 1 << MAX_SHIFT_BEFORE_STOP_SCALING;
+
+    struct TransformData {
+        Vector2f translation;
+        float rotation;
+        float scale;
+    };
+    // Component coords relative to the BVH node it's stored in, reduced to doubles when the node is built
+    struct NodeRelativeCoords {
+        Vector2d pos;
+        double inverseScale;
+    };
+    // BVH node origin relative to the camera, reduced to doubles once per draw so that components inside the node can skip big number math
+    struct CameraRelativeNodeOrigin {
+        Vector2d pos;
+        double inverseScale;
+    };
+
+    TransformData calculate_draw_transform(const CoordSpaceHelper& camCoords, const CoordSpaceHelper& coords);
+    // Same transform as calculate_draw_transform up to float rounding, see tests/ComponentDrawTransformTests.cpp for the tolerance.
+    // Returns nullopt when the component is drawn at or past MAX_BEFORE_STOP_SCALING, which needs the exact path
+    std::optional<TransformData> calculate_draw_transform_from_node(const CameraRelativeNodeOrigin& nodeOrigin, const NodeRelativeCoords& relativeCoords, double camRotation, double rotation);
+    NodeRelativeCoords calculate_node_relative_coords(const CoordSpaceHelper& nodeCoords, const CoordSpaceHelper& coords);
+    // Returns nullopt when the camera is zoomed in past MAX_SHIFT_BEFORE_STOP_SCALING relative to the node
+    std::optional<CameraRelativeNodeOrigin> calculate_camera_relative_node_origin(const CoordSpaceHelper& camCoords, const CoordSpaceHelper& nodeCoords);
+}
@@ -78,7 +78,7 @@ void ImageCanvasComponent::draw_download_progress_bar(SkCanvas* canvas, const Dr
         return;
     if(compContainer->should_draw(drawData)) {
         canvas->save();
-        compContainer->canvas_do_transform(canvas, compContainer->calculate_draw_transform(drawData.cam.c, compContainer->coords));
+        compContainer->canvas_do_transform(canvas, ComponentDrawTransform::calculate_draw_transform(drawData.cam.c, compContainer->coords));
         SkPaint p;
         p.setStroke(true);
         p.setStrokeWidth(10.0f);
@@ -187,3 +187,12 @@ SCollision::AABB<float> ImageCanvasComponent::get_obj_coord_bounds() const {
         startingRect = get_cropped_rectangle(d.p1, d.p2, d.cropP1, d.cropP2);
     return startingRect;
 }
+
+std::optional<SCollision::AABB<float>> ImageCanvasComponent::get_opaque_obj_coord_bounds(const DrawData& drawData) const {
+    if(d.editing)
+        return std::nullopt;
+    ResourceDisplay* display = drawData.rMan->get_display_data(d.imageID);
+    if(!display || !display->is_opaque())
+        return std::nullopt;
+    return get_obj_coord_bounds();
+}
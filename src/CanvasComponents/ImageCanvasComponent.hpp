@@ -58,5 +58,6 @@ class ImageCanvasComponent : public CanvasComponent {
         virtual bool collides_within_coords_point(const Vector2f& checkAgainst) const override;
         virtual bool collides_within_coords_skpath(const SkPath& checkAgainst) const override;
         virtual SCollision::AABB<float> get_obj_coord_bounds() const override;
+        virtual std::optional<SCollision::AABB<float>> get_opaque_obj_coord_bounds(const DrawData& drawData) const override;
 };
 
@@ -22,6 +22,7 @@
 #include <chrono>
 #include <include/core/SkPathTypes.h>
 #include <limits>
+#include <algorithm>
 #include <Eigen/Geometry>
 #include "BrushComponentCode.hpp"
 #include "CanvasComponent.hpp"
@@ -36,9 +37,14 @@
 #include "Helpers/SCollision.hpp"
 #include "../DrawingProgram/DrawingProgram.hpp"
 #include "../World.hpp"
-#include <CDT/include/CDT.h>
+#include "../RenderStats.hpp"
 #include <clipper2/clipper.h>
 #include <Helpers/Logger.hpp>
+#include <include/core/SkSurface.h>
+#include <include/core/SkPixmap.h>
+
+bool MeshCanvasComponent::USE_BATCHED_DRAW = true;
+bool MeshCanvasComponent::USE_LOD = true;
 
 template <typename Archive> void skpath_write(const SkPath& p, Archive& a) {
     std::vector<std::vector<SkPoint>> contours;
@@ -140,11 +146,312 @@ std::optional<Vector4f> MeshCanvasComponent::get_stroke_color() const {
     return d.color;
 }
 
+static std::vector<std::vector<SkPoint>> get_path_contours(const SkPath& path) {
+    std::vector<std::vector<SkPoint>> contours;
+    SkPath::Iter iter(path, false);
+    for(;;) {
+        std::optional<SkPath::IterRec> rec = iter.next();
+        if(!rec.has_value())
+            break;
+        if(rec->fVerb == SkPathVerb::kMove)
+            contours.emplace_back().emplace_back(rec->fPoints[0]);
+        else if(rec->fVerb == SkPathVerb::kLine)
+            contours.back().emplace_back(rec->fPoints[1]);
+    }
+    for(auto& contour : contours) {
+        if(contour.size() > 1 && contour.front() == contour.back())
+            contour.pop_back();
+    }
+    return contours;
+}
+
+// Number of triangles in any triangulation of the path's outline. A contour with V points is V - 2 triangles, and each hole
+// (which winds the other way after simplify_paths) adds two triangles to the contour around it, so holes count as V + 2
+static size_t get_path_triangle_count(const SkPath& path) {
+    std::vector<std::vector<SkPoint>> contours = get_path_contours(path);
+    std::vector<double> contourAreas;
+    double totalArea = 0.0;
+    for(const std::vector<SkPoint>& contour : contours) {
+        double area = 0.0;
+        for(size_t i = 0; i < contour.size(); i++)
+            area += static_cast<double>(contour[i].cross(contour[(i + 1) % contour.size()]));
+        contourAreas.emplace_back(area);
+        totalArea += area;
+    }
+    size_t triangleCount = 0;
+    for(size_t i = 0; i < contours.size(); i++) {
+        if(contours[i].size() < 3)
+            continue;
+        bool isHole = (contourAreas[i] < 0.0) != (totalArea < 0.0);
+        triangleCount += isHole ? contours[i].size() + 2 : contours[i].size() - 2;
+    }
+    return triangleCount;
+}
+
+static float point_segment_distance_squared(const SkPoint& p, const SkPoint& a, const SkPoint& b) {
+    SkVector ab = b - a;
+    float abLengthSquared = ab.dot(ab);
+    float t = abLengthSquared == 0.0f ? 0.0f : std::clamp((p - a).dot(ab) / abLengthSquared, 0.0f, 1.0f);
+    SkVector toClosest = p - (a + ab * t);
+    return toClosest.dot(toClosest);
+}
+
+// Marks the points between first and last that Douglas-Peucker keeps at the given tolerance
+static void douglas_peucker_mark(const std::vector<SkPoint>& points, size_t first, size_t last, float toleranceSquared, std::vector<bool>& keep) {
+    std::vector<std::pair<size_t, size_t>> ranges{{first, last}};
+    while(!ranges.empty()) {
+        auto [a, b] = ranges.back();
+        ranges.pop_back();
+        float maxDistanceSquared = 0.0f;
+        size_t maxIndex = a;
+        for(size_t i = a + 1; i < b; i++) {
+            float distanceSquared = point_segment_distance_squared(points[i], points[a], points[b]);
+            if(distanceSquared > maxDistanceSquared) {
+                maxDistanceSquared = distanceSquared;
+                maxIndex = i;
+            }
+        }
+        if(maxDistanceSquared > toleranceSquared) {
+            keep[maxIndex] = true;
+            ranges.emplace_back(a, maxIndex);
+            ranges.emplace_back(maxIndex, b);
+        }
+    }
+}
+
+static SkPath douglas_peucker_simplify(const SkPath& path, float tolerance) {
+    SkPathBuilder builder(path.getFillType());
+    for(std::vector<SkPoint>& contour : get_path_contours(path)) {
+        if(contour.size() < 3)
+            continue;
+        // The contour is closed, so split it at its first point and the point farthest from it
+        size_t farthest = 0;
+        float farthestDistanceSquared = 0.0f;
+        for(size_t i = 1; i < contour.size(); i++) {
+            SkVector toFirst = contour[i] - contour[0];
+            if(toFirst.dot(toFirst) > farthestDistanceSquared) {
+                farthestDistanceSquared = toFirst.dot(toFirst);
+                farthest = i;
+            }
+        }
+        if(farthest == 0)
+            continue;
+        contour.emplace_back(contour[0]);
+        std::vector<bool> keep(contour.size(), false);
+        keep[0] = true;
+        keep[farthest] = true;
+        douglas_peucker_mark(contour, 0, farthest, tolerance * tolerance, keep);
+        douglas_peucker_mark(contour, farthest, contour.size() - 1, tolerance * tolerance, keep);
+
+        // Thin contours (like a short stroke) would be removed, so keep their widest point to draw them as a thin triangle instead
+        if(std::count(keep.begin(), keep.end() - 1, true) < 3) {
+            size_t widest = 0;
+            float widestDistanceSquared = 0.0f;
+            for(size_t i = 1; i < contour.size() - 1; i++) {
+                float distanceSquared = point_segment_distance_squared(contour[i], contour[0], contour[farthest]);
+                if(distanceSquared > widestDistanceSquared) {
+                    widestDistanceSquared = distanceSquared;
+                    widest = i;
+                }
+            }
+            keep[widest] = true;
+        }
+
+        std::vector<SkPoint> simplified;
+        for(size_t i = 0; i < contour.size() - 1; i++) {
+            if(keep[i])
+                simplified.emplace_back(contour[i]);
+        }
+        if(simplified.size() >= 3)
+            builder.addPolygon({simplified.data(), simplified.size()}, true);
+    }
+    return builder.detach();
+}
+
+bool MeshCanvasComponent::is_lod_collapsed(const SkRect& bounds, float pixelsPerUnit) {
+    return USE_LOD && std::max(bounds.width(), bounds.height()) * pixelsPerUnit < LOD_COLLAPSE_PIXEL_SIZE;
+}
+
+void MeshCanvasComponent::refresh_lod_chain_source() const {
+    // Same as the triangulation, the path is compared since d can be changed from outside this class
+    if(lodChain.sourcePath != d.meshPath)
+        lodChain = LODChain{.sourcePath = d.meshPath};
+}
+
+MeshCanvasComponent::LODPath MeshCanvasComponent::get_lod_path(float pixelsPerUnit) const {
+    float tolerance = LOD_MAXIMUM_ERROR_PIXELS / pixelsPerUnit;
+    std::scoped_lock lodChainLock(lodChainMutex);
+    refresh_lod_chain_source();
+    if(!USE_LOD || !(tolerance >= LOD_FINEST_TOLERANCE)) {
+        if(!lodChain.sourceTriangleCount.has_value())
+            lodChain.sourceTriangleCount = get_path_triangle_count(d.meshPath);
+        return {d.meshPath, lodChain.sourceTriangleCount.value()};
+    }
+    size_t level = std::min(static_cast<size_t>(std::log2(tolerance / LOD_FINEST_TOLERANCE)), LOD_LEVEL_COUNT - 1);
+    std::optional<LODPath>& lodPath = lodChain.levels[level];
+    if(!lodPath.has_value()) {
+        SkPath simplifiedPath = douglas_peucker_simplify(d.meshPath, LOD_FINEST_TOLERANCE * static_cast<float>(1 << level));
+        size_t triangleCount = get_path_triangle_count(simplifiedPath);
+        lodPath = LODPath{std::move(simplifiedPath), triangleCount};
+    }
+    return lodPath.value();
+}
+
+float MeshCanvasComponent::get_lod_coverage() const {
+    std::scoped_lock lodChainLock(lodChainMutex);
+    refresh_lod_chain_source();
+    if(!lodChain.coverage.has_value()) {
+        // Shoelace formula. Holes wind the other way after simplify_paths, so they're subtracted
+        double area = 0.0;
+        for(const std::vector<SkPoint>& contour : get_path_contours(d.meshPath)) {
+            for(size_t i = 0; i < contour.size(); i++)
+                area += static_cast<double>(contour[i].cross(contour[(i + 1) % contour.size()]));
+        }
+        SkRect bounds = d.meshPath.getBounds();
+        double boundsArea = static_cast<double>(bounds.width()) * static_cast<double>(bounds.height());
+        lodChain.coverage = boundsArea == 0.0 ? 1.0f : static_cast<float>(std::clamp(std::fabs(area) * 0.5 / boundsArea, 0.0, 1.0));
+    }
+    return lodChain.coverage.value();
+}
+
 void MeshCanvasComponent::draw(SkCanvas* canvas, const DrawData& drawData, const std::shared_ptr<void>& predrawData) const {
     SkPaint paint;
     paint.setColor4f(SkColor4f{d.color.x(), d.color.y(), d.color.z(), d.color.w()});
     paint.setAntiAlias(drawData.skiaAA);
-    canvas->drawPath(d.meshPath, paint);
+
+    // Scale is uniform, so the determinant is its square
+    SkMatrix canvasMatrix = canvas->getLocalToDeviceAs3x3();
+    float pixelsPerUnit = drawData.isSVGRender ? std::numeric_limits<float>::infinity() : std::sqrt(std::fabs(canvasMatrix.getScaleX() * canvasMatrix.getScaleY() - canvasMatrix.getSkewX() * canvasMatrix.getSkewY()));
+    if(is_lod_collapsed(d.meshPath.getBounds(), pixelsPerUnit)) {
+        paint.setAlphaf(paint.getAlphaf() * get_lod_coverage());
+        canvas->drawRect(d.meshPath.getBounds(), paint);
+        RenderStats::current().meshTrianglesSubmitted += 2;
+        return;
+    }
+
+    if(predrawData) {
+        auto triangulationToDraw = std::static_pointer_cast<const Triangulation>(predrawData);
+        if(!triangulationToDraw->trianglePoints.empty()) {
+            const std::vector<SkPoint>& points = triangulationToDraw->trianglePoints;
+            canvas->drawVertices(SkVertices::MakeCopy(SkVertices::kTriangles_VertexMode, static_cast<int>(points.size()), points.data(), nullptr, nullptr), SkBlendMode::kModulate, paint);
+            RenderStats::current().meshTrianglesSubmitted += points.size() / 3;
+            return;
+        }
+    }
+    LODPath pathToDraw = get_lod_path(pixelsPerUnit);
+    canvas->drawPath(pathToDraw.path, paint);
+    RenderStats::current().meshTrianglesSubmitted += pathToDraw.triangleCount;
+}
+
+bool MeshCanvasComponent::uses_batched_draw(const DrawData& drawData) {
+    // SkVertices don't have Skia's analytic antialiasing, so batched meshes would have jagged edges. With the default Skia antialiasing,
+    // meshes keep being drawn as paths, and batching is only used with the None or dynamic MSAA antialiasing settings. SVGs can't have
+    // SkVertices written to them either
+    return USE_BATCHED_DRAW && !drawData.skiaAA && !drawData.isSVGRender;
+}
+
+std::shared_ptr<void> MeshCanvasComponent::get_predraw_data(const DrawData& drawData) const {
+    // Triangulating here instead of while drawing lets it run in parallel with the other components. Components that aren't in
+    // a cache tree node yet (such as strokes being drawn) change often, so they're drawn as paths instead of being triangulated every frame
+    if(uses_batched_draw(drawData) && !compContainer->cacheParentBvhNode.expired())
+        return std::const_pointer_cast<Triangulation>(get_triangulation());
+    return nullptr;
+}
+
+size_t MeshCanvasComponent::draw_batch(SkCanvas* canvas, const DrawData& drawData, std::span<CanvasComponentContainer::ObjInfo* const> comps) {
+    auto get_batch_triangulation = [](CanvasComponentContainer::ObjInfo* c) -> const Triangulation* {
+        if(c->obj->get_comp().get_type() != CanvasComponentType::MESH || !c->obj->preDrawDataHolder.has_value())
+            return nullptr;
+        auto& preDrawData = c->obj->preDrawDataHolder.value();
+        // Accurately drawn meshes have a clipped path as predraw data instead
+        if(preDrawData.transformData.scale >= CanvasComponentContainer::COMP_MAX_BEFORE_STOP_SCALING || !preDrawData.extraData)
+            return nullptr;
+        // Collapsed meshes are drawn as a rectangle by MeshCanvasComponent::draw
+        if(is_lod_collapsed(static_cast<const MeshCanvasComponent&>(c->obj->get_comp()).d.meshPath.getBounds(), preDrawData.transformData.scale))
+            return nullptr;
+        auto triangulationToDraw = static_cast<const Triangulation*>(preDrawData.extraData.get());
+        return triangulationToDraw->trianglePoints.empty() ? nullptr : triangulationToDraw;
+    };
+
+    if(comps.empty() || !get_batch_triangulation(comps.front()))
+        return 0;
+
+    // Only consecutive components are merged, since merging with a component further ahead would change which one is drawn on top
+    const Vector4f& color = static_cast<const MeshCanvasComponent&>(comps.front()->obj->get_comp()).d.color;
+    std::vector<SkPoint> batchPoints;
+    size_t batchSize = 0;
+    for(; batchSize < comps.size(); batchSize++) {
+        CanvasComponentContainer::ObjInfo* c = comps[batchSize];
+        const Triangulation* triangulationToDraw = get_batch_triangulation(c);
+        if(!triangulationToDraw || static_cast<const MeshCanvasComponent&>(c->obj->get_comp()).d.color != color)
+            break;
+        // Same transform as CanvasComponentContainer::canvas_do_transform, applied to the points instead of the canvas
+        auto& transformData = c->obj->preDrawDataHolder.value().transformData;
+        SkMatrix m = SkMatrix::Scale(transformData.scale, transformData.scale);
+        m.preRotate(transformData.rotation);
+        m.preTranslate(transformData.translation.x(), transformData.translation.y());
+        triangulationToDraw->append_mapped_triangle_points(batchPoints, m);
+    }
+
+    SkPaint paint;
+    paint.setColor4f(SkColor4f{color.x(), color.y(), color.z(), color.w()});
+    paint.setAntiAlias(drawData.skiaAA);
+    canvas->drawVertices(SkVertices::MakeCopy(SkVertices::kTriangles_VertexMode, static_cast<int>(batchPoints.size()), batchPoints.data(), nullptr, nullptr), SkBlendMode::kModulate, paint);
+
+    RenderStats::Frame& stats = RenderStats::current();
+    stats.componentsDrawn += batchSize;
+    stats.meshTrianglesSubmitted += batchPoints.size() / 3;
+    return batchSize;
+}
+
+void MeshCanvasComponent::log_batched_draw_comparison(DrawingProgram& drawP, const DrawData& drawData) {
+    if(!drawP.layerMan.layer_tree_root_exists())
+        return;
+
+    DrawData compareDrawData = drawData;
+    compareDrawData.skiaAA = false;
+    SkImageInfo imgInfo = SkImageInfo::MakeN32Premul(drawData.cam.viewingArea.x(), drawData.cam.viewingArea.y());
+    bool oldUseBatchedDraw = USE_BATCHED_DRAW;
+
+    auto draw_to_raster_surface = [&](bool useBatchedDraw) {
+        USE_BATCHED_DRAW = useBatchedDraw;
+        sk_sp<SkSurface> surface = SkSurfaces::Raster(imgInfo);
+        surface->getCanvas()->clear(SkColor4f{0.0f, 0.0f, 0.0f, 0.0f});
+        drawP.layerMan.draw(surface->getCanvas(), compareDrawData);
+        return surface;
+    };
+    sk_sp<SkSurface> pathFillSurface = draw_to_raster_surface(false);
+    sk_sp<SkSurface> batchedSurface = draw_to_raster_surface(true);
+    USE_BATCHED_DRAW = oldUseBatchedDraw;
+
+    SkPixmap pathFillPixels;
+    SkPixmap batchedPixels;
+    if(!pathFillSurface->peekPixels(&pathFillPixels) || !batchedSurface->peekPixels(&batchedPixels))
+        return;
+
+    size_t differentPixels = 0;
+    unsigned maxChannelDifference = 0;
+    for(int y = 0; y < imgInfo.height(); y++) {
+        for(int x = 0; x < imgInfo.width(); x++) {
+            uint32_t a = *pathFillPixels.addr32(x, y);
+            uint32_t b = *batchedPixels.addr32(x, y);
+            if(a == b)
+                continue;
+            differentPixels++;
+            for(unsigned shift = 0; shift < 32; shift += 8)
+                maxChannelDifference = std::max(maxChannelDifference, static_cast<unsigned>(std::abs(static_cast<int>((a >> shift) & 0xFF) - static_cast<int>((b >> shift) & 0xFF))));
+        }
+    }
+    Logger::get().log(Logger::LogType::INFO, "[MeshCanvasComponent::log_batched_draw_comparison] " + std::to_string(differentPixels) + " of " + std::to_string(static_cast<size_t>(imgInfo.width()) * imgInfo.height()) + " pixels differ from the path fill, maximum channel difference " + std::to_string(maxChannelDifference));
+}
+
+std::shared_ptr<const MeshCanvasComponent::Triangulation> MeshCanvasComponent::get_triangulation() const {
+    std::scoped_lock triangulationLock(triangulationMutex);
+    // Comparing against a copy of the triangulated path is cheap when the path hasn't changed, since the copy shares the same path data.
+    // The path is compared instead of resetting the triangulation when the path changes, since d can be changed from outside this class
+    if(!triangulation || triangulation->triangulatedPath != d.meshPath)
+        triangulation = Triangulation::triangulate_path(d.meshPath);
+    return triangulation;
 }
 
 std::shared_ptr<void> MeshCanvasComponent::get_predraw_data_accurate(const DrawData& drawData, const CoordSpaceHelper& coords) const {
@@ -153,54 +460,8 @@ std::shared_ptr<void> MeshCanvasComponent::get_predraw_data_accurate(const DrawD
         viewGenerousColliderInObjSpace.min -= Vector2f{1.0f, 1.0f};
         viewGenerousColliderInObjSpace.max += Vector2f{1.0f, 1.0f};
 
-        // GrTriangulator is faster, but isn't as robust
-        //GrCpuVertexAllocator cpuAlloc;
-        //bool isLinear;
-        //GrTriangulator::PathToTriangles(d.meshPath, 0.0001f, viewGenerousColliderInObjSpace.get_sk_rect(), &cpuAlloc, &isLinear);
-        //sk_sp<GrThreadSafeCache::VertexData> detachedVertexData = cpuAlloc.detachVertexData();
-        //if(!detachedVertexData)
-        //    return nullptr;
-        //if(detachedVertexData->vertexSize() != 8)
-        //    throw std::runtime_error("[MeshCanvasComponent::get_predraw_data_accurate] Vertex data vertex size not equal to 8");
-
-        // Triangulation implementation using CDT
-        SkPath::Iter iter(d.meshPath, true);
-        std::vector<CDT::V2d<float>> points;
-        std::vector<CDT::Edge> edges;
-
-        // Makes duplicate vertices by default, but duplicates are impossible to completely remove, so just rely on RemoveDuplicatesAndRemapEdges
-        for(;;) {
-            std::optional<SkPath::IterRec> rec = iter.next();
-            if(!rec.has_value())
-                break;
-
-            switch(rec->fVerb) {
-                case SkPathVerb::kClose:
-                    break;
-                case SkPathVerb::kLine: {
-                    CDT::V2d<float> newPoint{rec->fPoints[1].x(), rec->fPoints[1].y()};
-                    points.emplace_back(newPoint);
-                    edges.emplace_back(points.size() - 2, points.size() - 1);
-                    break;
-                }
-                case SkPathVerb::kMove:
-                    points.emplace_back(rec->fPoints[0].x(), rec->fPoints[0].y());
-                    break;
-                default:
-                    throw std::runtime_error("[get_predraw_data_accurate] Illegal verb " + std::to_string(static_cast<unsigned>(rec->fVerb)));
-                    break;
-            }
-        }
-
-        CDT::RemoveDuplicatesAndRemapEdges(
-            points,
-            edges
-        );
-
-        CDT::Triangulation<float> cdt(CDT::VertexInsertionOrder::Auto, CDT::IntersectingConstraintEdges::TryResolve, 0.001f);
-        cdt.insertVertices(points);
-        cdt.insertEdges(edges);
-        cdt.eraseOuterTrianglesAndHoles();
+        // Triangulation is cached in object space, so only the triangles in view have to be clipped every frame
+        std::shared_ptr<const Triangulation> triangulationToClip = get_triangulation();
 
         std::vector<std::array<SkPoint, 3>> finalTrianglePoints;
 
@@ -211,53 +472,26 @@ std::shared_ptr<void> MeshCanvasComponent::get_predraw_data_accurate(const DrawD
             return resultList;
         };
 
-        // GrTriangulator
-        //for(int i = 0; i < detachedVertexData->numVertices(); i += 3) {
-        //    Vector2f v1 = {static_cast<const float*>(detachedVertexData->vertices())[i], static_cast<const float*>(detachedVertexData->vertices())[i + 1]};
-        //    Vector2f v2 = {static_cast<const float*>(detachedVertexData->vertices())[i + 2], static_cast<const float*>(detachedVertexData->vertices())[i + 3]};
-        //    Vector2f v3 = {static_cast<const float*>(detachedVertexData->vertices())[i + 4], static_cast<const float*>(detachedVertexData->vertices())[i + 5]};
-        // CDT
-        for(size_t i = 0; i < cdt.triangles.size(); i++) {
-            auto& tri = cdt.triangles[i].vertices;
-            Vector2f v1{cdt.vertices[tri[0]].x, cdt.vertices[tri[0]].y};
-            Vector2f v2{cdt.vertices[tri[1]].x, cdt.vertices[tri[1]].y};
-            Vector2f v3{cdt.vertices[tri[2]].x, cdt.vertices[tri[2]].y};
-            SCollision::Triangle triCollider(v1, v2, v3);
-            if(SCollision::collide(triCollider.bounds, viewGenerousColliderInObjSpace)) {
-                std::vector<std::array<WorldVec, 3>> clipList;
-                clipList.emplace_back(std::array<WorldVec, 3>{coords.from_space(triCollider.p[0]), coords.from_space(triCollider.p[1]), coords.from_space(triCollider.p[2])});
-                clipList = clipListFunc(clipList, {drawData.cam.viewingAreaGenerousCollider.min, drawData.cam.viewingAreaGenerousCollider.top_right()}, [&](const WorldVec& p) {
-                    return p.y() > drawData.cam.viewingAreaGenerousCollider.min.y();
-                });
-                clipList = clipListFunc(clipList, {drawData.cam.viewingAreaGenerousCollider.max, drawData.cam.viewingAreaGenerousCollider.bottom_left()}, [&](const WorldVec& p) {
-                    return p.y() < drawData.cam.viewingAreaGenerousCollider.max.y();
-                });
-                clipList = clipListFunc(clipList, {drawData.cam.viewingAreaGenerousCollider.min, drawData.cam.viewingAreaGenerousCollider.bottom_left()}, [&](const WorldVec& p) {
-                    return p.x() > drawData.cam.viewingAreaGenerousCollider.min.x();
-                });
-                clipList = clipListFunc(clipList, {drawData.cam.viewingAreaGenerousCollider.max, drawData.cam.viewingAreaGenerousCollider.top_right()}, [&](const WorldVec& p) {
-                    return p.x() < drawData.cam.viewingAreaGenerousCollider.max.x();
-                });
-                for(auto& tri : clipList) {
-                    auto& c = drawData.cam.c;
-                    finalTrianglePoints.emplace_back(std::array<SkPoint, 3>{convert_vec2<SkPoint>(c.to_space(tri[0])), convert_vec2<SkPoint>(c.to_space(tri[1])), convert_vec2<SkPoint>(c.to_space(tri[2]))});
-                }
+        triangulationToClip->triangleTree.is_collide_triangle_bounds_func(viewGenerousColliderInObjSpace, [&](const SCollision::Triangle<float>& triCollider) {
+            std::vector<std::array<WorldVec, 3>> clipList;
+            clipList.emplace_back(std::array<WorldVec, 3>{coords.from_space(triCollider.p[0]), coords.from_space(triCollider.p[1]), coords.from_space(triCollider.p[2])});
+            clipList = clipListFunc(clipList, {drawData.cam.viewingAreaGenerousCollider.min, drawData.cam.viewingAreaGenerousCollider.top_right()}, [&](const WorldVec& p) {
+                return p.y() > drawData.cam.viewingAreaGenerousCollider.min.y();
+            });
+            clipList = clipListFunc(clipList, {drawData.cam.viewingAreaGenerousCollider.max, drawData.cam.viewingAreaGenerousCollider.bottom_left()}, [&](const WorldVec& p) {
+                return p.y() < drawData.cam.viewingAreaGenerousCollider.max.y();
+            });
+            clipList = clipListFunc(clipList, {drawData.cam.viewingAreaGenerousCollider.min, drawData.cam.viewingAreaGenerousCollider.bottom_left()}, [&](const WorldVec& p) {
+                return p.x() > drawData.cam.viewingAreaGenerousCollider.min.x();
+            });
+            clipList = clipListFunc(clipList, {drawData.cam.viewingAreaGenerousCollider.max, drawData.cam.viewingAreaGenerousCollider.top_right()}, [&](const WorldVec& p) {
+                return p.x() < drawData.cam.viewingAreaGenerousCollider.max.x();
+            });
+            for(auto& tri : clipList) {
+                auto& c = drawData.cam.c;
+                finalTrianglePoints.emplace_back(std::array<SkPoint, 3>{convert_vec2<SkPoint>(c.to_space(tri[0])), convert_vec2<SkPoint>(c.to_space(tri[1])), convert_vec2<SkPoint>(c.to_space(tri[2]))});
             }
-        }
-
-        // Match points that are close enough. I don't think this is required.
-        //if(!finalTrianglePoints.empty()) {
-        //    for(size_t i = 0; i < finalTrianglePoints.size() - 1; i++) {
-        //        for(size_t j = 0; j < 3; j++) {
-        //            for(size_t k = i + 1; k < finalTrianglePoints.size(); k++) {
-        //                for(size_t l = 0; l < 3; l++) {
-        //                    if(std::fabs(finalTrianglePoints[i][j].fX - finalTrianglePoints[k][l].fX) < 0.0001f && std::fabs(finalTrianglePoints[i][j].fY - finalTrianglePoints[k][l].fY) < 0.0001f && finalTrianglePoints[k][l] != finalTrianglePoints[i][j])
-        //                        finalTrianglePoints[k][l] = finalTrianglePoints[i][j];
-        //                }
-        //            }
-        //        }
-        //    }
-        //}
+        });
 
         if(finalTrianglePoints.empty())
             return nullptr;
@@ -280,6 +514,8 @@ bool MeshCanvasComponent::accurate_draw(SkCanvas* canvas, const DrawData& drawDa
             paint.setColor4f(SkColor4f{d.color.x(), d.color.y(), d.color.z(), d.color.w()});
             paint.setAntiAlias(drawData.skiaAA);
             canvas->drawPath(*pathToDraw, paint);
+            // The clipped path is made of one closed triangle per contour
+            RenderStats::current().meshTrianglesSubmitted += pathToDraw->countPoints() / 3;
         }
     }
 
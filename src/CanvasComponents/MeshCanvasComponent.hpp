@@ -19,10 +19,14 @@
 #pragma once
 #include "BrushComponentCode.hpp"
 #include "CanvasComponent.hpp"
+#include "MeshTriangulation.hpp"
 #include "Helpers/SCollision.hpp"
 #include <Helpers/Serializers.hpp>
 #include <include/core/SkPath.h>
 #include <include/core/SkPathBuilder.h>
+#include <array>
+#include <mutex>
+#include <span>
 
 class MeshCanvasComponent : public CanvasComponent {
     public:
@@ -43,9 +47,19 @@ class MeshCanvasComponent : public CanvasComponent {
             SkPath meshPath;
             Vector4f color;
         } d;
+
+        static bool USE_BATCHED_DRAW; // Draw meshes as triangles with SkVertices. Has no effect with Skia antialiasing, which is the default
+        static bool USE_LOD; // Draw simplified outlines of meshes that are small on screen
+        static bool uses_batched_draw(const DrawData& drawData);
+        // Draws the run of meshes with the same color at the front of comps as one SkVertices draw, using their preDrawDataHolder.
+        // Returns how many components were drawn, which is 0 if the front component can't be drawn this way
+        static size_t draw_batch(SkCanvas* canvas, const DrawData& drawData, std::span<CanvasComponentContainer::ObjInfo* const> comps);
+        // Draws the layers within the camera view with and without batched draws on CPU raster surfaces, and logs how many pixels differ
+        static void log_batched_draw_comparison(DrawingProgram& drawP, const DrawData& drawData);
     private:
         virtual void draw(SkCanvas* canvas, const DrawData& drawData, const std::shared_ptr<void>& predrawData) const override;
         virtual bool accurate_draw(SkCanvas* canvas, const DrawData& drawData, const CoordSpaceHelper& coords, const std::shared_ptr<void>& predrawData) const override;
+        virtual std::shared_ptr<void> get_predraw_data(const DrawData& drawData) const override;
         virtual std::shared_ptr<void> get_predraw_data_accurate(const DrawData& drawData, const CoordSpaceHelper& coords) const override;
         virtual void initialize_draw_data(DrawingProgram& drawP) override;
         virtual bool collides_within_coords_point(const Vector2f& checkAgainst) const override;
@@ -55,5 +69,33 @@ class MeshCanvasComponent : public CanvasComponent {
         bool should_draw_extra(const DrawData& drawData, const CoordSpaceHelper& coords) const override;
         virtual SCollision::AABB<float> get_obj_coord_bounds() const override;
         SCollision::BVHContainer<float> collisionTree;
+
+        typedef MeshTriangulation Triangulation;
+        std::shared_ptr<const Triangulation> get_triangulation() const;
+        mutable std::mutex triangulationMutex; // Predraw data is calculated from multiple threads
+        mutable std::shared_ptr<const Triangulation> triangulation;
+
+        // Outlines simplified with Douglas-Peucker, made when first drawn at each level. Level L is simplified with a tolerance of
+        // LOD_FINEST_TOLERANCE * 2^L object units, and the level drawn is the coarsest one that is off by at most LOD_MAXIMUM_ERROR_PIXELS
+        static constexpr float LOD_FINEST_TOLERANCE = 1.0f;
+        static constexpr float LOD_MAXIMUM_ERROR_PIXELS = 0.25f;
+        static constexpr size_t LOD_LEVEL_COUNT = 8;
+        static constexpr float LOD_COLLAPSE_PIXEL_SIZE = 2.0f; // Meshes smaller than this on screen are drawn as one rectangle
+        struct LODPath {
+            SkPath path;
+            size_t triangleCount; // Triangles Skia fills the path with, for RenderStats
+        };
+        struct LODChain {
+            SkPath sourcePath;
+            std::optional<size_t> sourceTriangleCount;
+            std::array<std::optional<LODPath>, LOD_LEVEL_COUNT> levels;
+            std::optional<float> coverage; // Fraction of the bounds covered by the mesh
+        };
+        static bool is_lod_collapsed(const SkRect& bounds, float pixelsPerUnit);
+        void refresh_lod_chain_source() const;
+        LODPath get_lod_path(float pixelsPerUnit) const;
+        float get_lod_coverage() const;
+        mutable std::mutex lodChainMutex;
+        mutable LODChain lodChain;
 };
 
@@ -0,0 +1,100 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "MeshTriangulation.hpp"
+#include <CDT/include/CDT.h>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+std::shared_ptr<const MeshTriangulation> MeshTriangulation::triangulate_path(const SkPath& path) {
+    auto toRet = std::make_shared<MeshTriangulation>();
+    toRet->triangulatedPath = path;
+    try {
+        // GrTriangulator is faster, but isn't as robust
+        //GrCpuVertexAllocator cpuAlloc;
+        //bool isLinear;
+        //GrTriangulator::PathToTriangles(path, 0.0001f, viewGenerousColliderInObjSpace.get_sk_rect(), &cpuAlloc, &isLinear);
+        //sk_sp<GrThreadSafeCache::VertexData> detachedVertexData = cpuAlloc.detachVertexData();
+        //if(!detachedVertexData)
+        //    return toRet;
+        //if(detachedVertexData->vertexSize() != 8)
+        //    throw std::runtime_error("[MeshTriangulation::triangulate_path] Vertex data vertex size not equal to 8");
+
+        // Triangulation implementation using CDT
+        SkPath::Iter iter(path, true);
+        std::vector<CDT::V2d<float>> points;
+        std::vector<CDT::Edge> edges;
+
+        // Makes duplicate vertices by default, but duplicates are impossible to completely remove, so just rely on RemoveDuplicatesAndRemapEdges
+        for(;;) {
+            std::optional<SkPath::IterRec> rec = iter.next();
+            if(!rec.has_value())
+                break;
+
+            switch(rec->fVerb) {
+                case SkPathVerb::kClose:
+                    break;
+                case SkPathVerb::kLine: {
+                    CDT::V2d<float> newPoint{rec->fPoints[1].x(), rec->fPoints[1].y()};
+                    points.emplace_back(newPoint);
+                    edges.emplace_back(points.size() - 2, points.size() - 1);
+                    break;
+                }
+                case SkPathVerb::kMove:
+                    points.emplace_back(rec->fPoints[0].x(), rec->fPoints[0].y());
+                    break;
+                default:
+                    throw std::runtime_error("[MeshTriangulation::triangulate_path] Illegal verb " + std::to_string(static_cast<unsigned>(rec->fVerb)));
+                    break;
+            }
+        }
+
+        CDT::RemoveDuplicatesAndRemapEdges(
+            points,
+            edges
+        );
+
+        CDT::Triangulation<float> cdt(CDT::VertexInsertionOrder::Auto, CDT::IntersectingConstraintEdges::TryResolve, 0.001f);
+        cdt.insertVertices(points);
+        cdt.insertEdges(edges);
+        cdt.eraseOuterTrianglesAndHoles();
+
+        SCollision::ColliderCollection<float> triangles;
+        triangles.triangle.reserve(cdt.triangles.size());
+        toRet->trianglePoints.reserve(cdt.triangles.size() * 3);
+        for(size_t i = 0; i < cdt.triangles.size(); i++) {
+            auto& tri = cdt.triangles[i].vertices;
+            triangles.triangle.emplace_back(Vector2f{cdt.vertices[tri[0]].x, cdt.vertices[tri[0]].y}, Vector2f{cdt.vertices[tri[1]].x, cdt.vertices[tri[1]].y}, Vector2f{cdt.vertices[tri[2]].x, cdt.vertices[tri[2]].y});
+            for(size_t j = 0; j < 3; j++)
+                toRet->trianglePoints.emplace_back(SkPoint{cdt.vertices[tri[j]].x, cdt.vertices[tri[j]].y});
+        }
+        toRet->triangleTree.calculate_bvh_recursive(triangles, TRIANGLE_TREE_MAX_DEPTH);
+    }
+    catch(...) {
+        // Leave the triangulation empty, so that a path that can't be triangulated isn't attempted again every frame. It'll be drawn as a path instead
+        toRet->triangleTree.clear();
+        toRet->trianglePoints.clear();
+    }
+    return toRet;
+}
+
+void MeshTriangulation::append_mapped_triangle_points(std::vector<SkPoint>& points, const SkMatrix& m) const {
+    size_t oldSize = points.size();
+    points.resize(oldSize + trianglePoints.size());
+    m.mapPoints(SkSpan<SkPoint>(points.data() + oldSize, trianglePoints.size()), trianglePoints);
+}
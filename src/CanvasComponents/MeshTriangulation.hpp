@@ -0,0 +1,37 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <include/core/SkPath.h>
+#include <include/core/SkMatrix.h>
+#include <Helpers/SCollision.hpp>
+#include <memory>
+#include <vector>
+
+// Triangles of a mesh in object space, used when the mesh is drawn accurately or batched. Separate from MeshCanvasComponent so that
+// the batched draw can be tested against the path fill without the rest of the canvas
+struct MeshTriangulation {
+    SkPath triangulatedPath;
+    SCollision::BVHContainer<float> triangleTree;
+    std::vector<SkPoint> trianglePoints; // Three points for each triangle
+
+    static constexpr int TRIANGLE_TREE_MAX_DEPTH = 16;
+    // Paths with curves or that CDT can't triangulate give an empty triangulation, and are drawn as paths instead
+    static std::shared_ptr<const MeshTriangulation> triangulate_path(const SkPath& path);
+    // Appends the triangle points mapped by m, so that several meshes can be drawn with one SkVertices
+    void append_mapped_triangle_points(std::vector<SkPoint>& points, const SkMatrix& m) const;
+};
@@ -156,3 +156,14 @@ bool RectangleCanvasComponent::collides_within_coords_skpath(const SkPath& check
 SCollision::AABB<float> RectangleCanvasComponent::get_obj_coord_bounds() const {
     return colliderPath.getBounds();
 }
+
+std::optional<SCollision::AABB<float>> RectangleCanvasComponent::get_opaque_obj_coord_bounds(const DrawData& drawData) const {
+    if((d.fillStrokeMode != 0 && d.fillStrokeMode != 2) || d.fillColor.w() < 1.0f)
+        return std::nullopt;
+    // The rounded corners are left out
+    Vector2f opaqueMin = d.p1.cwiseMin(d.p2) + Vector2f{d.cornerRadius, d.cornerRadius};
+    Vector2f opaqueMax = d.p1.cwiseMax(d.p2) - Vector2f{d.cornerRadius, d.cornerRadius};
+    if(opaqueMin.x() >= opaqueMax.x() || opaqueMin.y() >= opaqueMax.y())
+        return std::nullopt;
+    return SCollision::AABB<float>(opaqueMin, opaqueMax);
+}
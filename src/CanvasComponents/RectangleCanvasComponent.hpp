@@ -54,6 +54,7 @@ class RectangleCanvasComponent : public CanvasComponent {
         void create_draw_data();
         void create_collider();
         virtual SCollision::AABB<float> get_obj_coord_bounds() const override;
+        virtual std::optional<SCollision::AABB<float>> get_opaque_obj_coord_bounds(const DrawData& drawData) const override;
         SkPath rectPath;
         SkPath colliderPath;
 };
@@ -28,6 +28,8 @@
 
 using namespace RichText;
 
+float TextBoxCanvasComponent::GREEKING_PIXEL_HEIGHT = 4.0f;
+
 TextBoxCanvasComponent::TextBoxCanvasComponent():
     textBox(std::make_shared<TextBox>()),
     cursor(std::make_shared<TextBox::Cursor>())
@@ -114,6 +116,16 @@ void TextBoxCanvasComponent::draw(SkCanvas* canvas, const DrawData& drawData, co
     canvas->clipRect(clipR, drawData.skiaAA);
     canvas->translate(d.p1.x() + TEXTBOX_PADDING, d.p1.y() + TEXTBOX_PADDING);
 
+    if(!d.editing && !drawData.isSVGRender) {
+        // Scale is uniform, so the determinant is its square
+        SkMatrix canvasMatrix = canvas->getLocalToDeviceAs3x3();
+        float pixelsPerUnit = std::sqrt(std::fabs(canvasMatrix.getScaleX() * canvasMatrix.getScaleY() - canvasMatrix.getSkewX() * canvasMatrix.getSkewY()));
+        if(textBox->get_max_line_height() * pixelsPerUnit < GREEKING_PIXEL_HEIGHT) {
+            textBox->paint_greeked(canvas, drawData.skiaAA);
+            return;
+        }
+    }
+
     TextBox::PaintOpts paintOpts;
     paintOpts.cursorColor = {0.7f, 0.7f, 1.0f};
     if(d.editing && cursor)
@@ -26,6 +26,7 @@
 class TextBoxCanvasComponent : public CanvasComponent {
     public:
         constexpr static float TEXTBOX_PADDING = 5.0f;
+        static float GREEKING_PIXEL_HEIGHT; // Text with lines shorter than this on screen is drawn as bars, 0 to disable
 
         TextBoxCanvasComponent();
         virtual CanvasComponentType get_type() const override;
@@ -17,10 +17,18 @@
  */
 
 #include "CoordSpaceHelper.hpp"
-#include "MainProgram.hpp"
 #include <Helpers/MathExtras.hpp>
-#include "World.hpp"
-#include "MainProgram.hpp"
+
+#ifdef IS_CLIENT
+    #include "World.hpp"
+    #include "MainProgram.hpp"
+#endif
+
+// The AVX2 kernel is compiled with a target attribute and picked at runtime, so builds for generic x86-64 still use it where it's supported
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define COORD_SPACE_HELPER_AVX2_DISPATCH
+    #include <immintrin.h>
+#endif
 
 CoordSpaceHelper::CoordSpaceHelper() { }
 
@@ -31,8 +39,8 @@ CoordSpaceHelper::CoordSpaceHelper(const WorldVec& initPos, const WorldScalar& i
 {}
 
 WorldVec rotate_world_coord(const WorldVec& a, double rotationAngle) {
-    FixedPoint::Number<boost::multiprecision::cpp_int, 15> s = FixedPoint::Number<boost::multiprecision::cpp_int, 15>(std::sin(rotationAngle));
-    FixedPoint::Number<boost::multiprecision::cpp_int, 15> c = FixedPoint::Number<boost::multiprecision::cpp_int, 15>(std::cos(rotationAngle));
+    FixedPoint::Number<WorldScalar::UnderlyingType, 15> s = FixedPoint::Number<WorldScalar::UnderlyingType, 15>(std::sin(rotationAngle));
+    FixedPoint::Number<WorldScalar::UnderlyingType, 15> c = FixedPoint::Number<WorldScalar::UnderlyingType, 15>(std::cos(rotationAngle));
     return {
         a.x().multiply_different_precision(c) - a.y().multiply_different_precision(s),
         a.x().multiply_different_precision(s) + a.y().multiply_different_precision(c)
@@ -111,8 +119,8 @@ void CoordSpaceHelper::scale_about(const WorldVec& scalePos, const WorldScalar&
 
 void CoordSpaceHelper::rotate_about(const WorldVec& rotatePos, double angle) {
     WorldVec a = pos - rotatePos;
-    FixedPoint::Number<boost::multiprecision::cpp_int, 15> s = FixedPoint::Number<boost::multiprecision::cpp_int, 15>(std::sin(angle));
-    FixedPoint::Number<boost::multiprecision::cpp_int, 15> c = FixedPoint::Number<boost::multiprecision::cpp_int, 15>(std::cos(angle));
+    FixedPoint::Number<WorldScalar::UnderlyingType, 15> s = FixedPoint::Number<WorldScalar::UnderlyingType, 15>(std::sin(angle));
+    FixedPoint::Number<WorldScalar::UnderlyingType, 15> c = FixedPoint::Number<WorldScalar::UnderlyingType, 15>(std::cos(angle));
     set_rotation(rotation + angle);
     pos = {
         rotatePos.x() + a.x().multiply_different_precision(c) - a.y().multiply_different_precision(s),
@@ -137,17 +145,105 @@ void CoordSpaceHelper::set_rotation(double newRotation) {
         rotation += 2.0 * std::numbers::pi;
 }
 
+// Points are converted in fixed size chunks so that batches don't need to allocate
+static constexpr size_t BATCH_CHUNK_SIZE = 64;
+
+// Applies (x, y) -> scale * (c * x - s * y, s * x + c * y) to every point in place
+static void rotate_scale_points_scalar(double* xs, double* ys, size_t count, double cS, double sS) {
+    for(size_t i = 0; i < count; i++) {
+        double x = xs[i];
+        double y = ys[i];
+        xs[i] = cS * x - sS * y;
+        ys[i] = sS * x + cS * y;
+    }
+}
+
+#ifdef COORD_SPACE_HELPER_AVX2_DISPATCH
+__attribute__((target("avx2"))) static void rotate_scale_points_avx2(double* xs, double* ys, size_t count, double cS, double sS) {
+    __m256d cV = _mm256_set1_pd(cS);
+    __m256d sV = _mm256_set1_pd(sS);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4) {
+        __m256d x = _mm256_loadu_pd(xs + i);
+        __m256d y = _mm256_loadu_pd(ys + i);
+        _mm256_storeu_pd(xs + i, _mm256_sub_pd(_mm256_mul_pd(cV, x), _mm256_mul_pd(sV, y)));
+        _mm256_storeu_pd(ys + i, _mm256_add_pd(_mm256_mul_pd(sV, x), _mm256_mul_pd(cV, y)));
+    }
+    rotate_scale_points_scalar(xs + i, ys + i, count - i, cS, sS);
+}
+#endif
+
+static void rotate_scale_points(double* xs, double* ys, size_t count, double c, double s, double scale) {
+#ifdef COORD_SPACE_HELPER_AVX2_DISPATCH
+    static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+    if(hasAVX2) {
+        rotate_scale_points_avx2(xs, ys, count, c * scale, s * scale);
+        return;
+    }
+#endif
+    rotate_scale_points_scalar(xs, ys, count, c * scale, s * scale);
+}
+
+void CoordSpaceHelper::to_space(std::span<const WorldVec> coords, std::span<Vector2f> out) const {
+    double scaleDouble = static_cast<double>(inverseScale);
+    if(!std::isfinite(scaleDouble) || !std::isfinite(1.0 / scaleDouble)) { // Scale can't be represented as a double, so use the exact path
+        for(size_t i = 0; i < coords.size(); i++)
+            out[i] = to_space(coords[i]);
+        return;
+    }
+
+    double c = std::cos(-rotation);
+    double s = std::sin(-rotation);
+    std::array<double, BATCH_CHUNK_SIZE> xs;
+    std::array<double, BATCH_CHUNK_SIZE> ys;
+    for(size_t chunkStart = 0; chunkStart < coords.size(); chunkStart += BATCH_CHUNK_SIZE) {
+        size_t chunkSize = std::min(BATCH_CHUNK_SIZE, coords.size() - chunkStart);
+        for(size_t i = 0; i < chunkSize; i++) {
+            xs[i] = static_cast<double>(coords[chunkStart + i].x() - pos.x());
+            ys[i] = static_cast<double>(coords[chunkStart + i].y() - pos.y());
+        }
+        rotate_scale_points(xs.data(), ys.data(), chunkSize, c, s, 1.0 / scaleDouble);
+        for(size_t i = 0; i < chunkSize; i++) {
+            // Offsets too far from pos overflow the double, but can still land on screen after the exact path divides by the scale
+            if(std::isfinite(xs[i]) && std::isfinite(ys[i]))
+                out[chunkStart + i] = Vector2f{static_cast<float>(xs[i]), static_cast<float>(ys[i])};
+            else
+                out[chunkStart + i] = to_space(coords[chunkStart + i]);
+        }
+    }
+}
+
+void CoordSpaceHelper::from_space(std::span<const Vector2f> coords, std::span<WorldVec> out) const {
+    double c = std::cos(rotation);
+    double s = std::sin(rotation);
+    std::array<double, BATCH_CHUNK_SIZE> xs;
+    std::array<double, BATCH_CHUNK_SIZE> ys;
+    for(size_t chunkStart = 0; chunkStart < coords.size(); chunkStart += BATCH_CHUNK_SIZE) {
+        size_t chunkSize = std::min(BATCH_CHUNK_SIZE, coords.size() - chunkStart);
+        for(size_t i = 0; i < chunkSize; i++) {
+            xs[i] = coords[chunkStart + i].x();
+            ys[i] = coords[chunkStart + i].y();
+        }
+        // Scaling stays in WorldScalar, since inverseScale can be much larger than what a double can accurately multiply by
+        rotate_scale_points(xs.data(), ys.data(), chunkSize, c, s, 1.0);
+        for(size_t i = 0; i < chunkSize; i++)
+            out[chunkStart + i] = WorldVec{WorldScalar(xs[i]), WorldScalar(ys[i])} * inverseScale + pos;
+    }
+}
+
+std::array<Vector2f, 4> CoordSpaceHelper::aabb_corners_to_space(const SCollision::AABB<WorldScalar>& aabb) const {
+    return to_space(std::array<WorldVec, 4>{aabb.min, aabb.top_right(), aabb.max, aabb.bottom_left()});
+}
+
 std::vector<Vector2f> CoordSpaceHelper::to_space(const std::vector<WorldVec>& coord) const {
     std::vector<Vector2f> toRet(coord.size());
-    for(size_t i = 0; i < coord.size(); i++)
-        toRet[i] = to_space(coord[i]);
+    to_space(std::span<const WorldVec>(coord), std::span<Vector2f>(toRet));
     return toRet;
 }
 
 std::vector<WorldVec> CoordSpaceHelper::from_space(const std::vector<Vector2f>& coord) const {
     std::vector<WorldVec> toRet(coord.size());
-    for(size_t i = 0; i < coord.size(); i++)
-        toRet[i] = from_space(coord[i]);
+    from_space(std::span<const Vector2f>(coord), std::span<WorldVec>(toRet));
     return toRet;
 }
 
@@ -165,6 +261,7 @@ std::vector<WorldVec> CoordSpaceHelper::from_space_world(const std::vector<World
     return toRet;
 }
 
+#ifdef IS_CLIENT
 Vector2f CoordSpaceHelper::get_mouse_pos(const World& w) const {
     return to_space(w.drawData.cam.c.from_space(w.main.input.mouse.pos));
 }
@@ -176,6 +273,7 @@ Vector2f CoordSpaceHelper::from_cam_space_to_this(const World& w, const Vector2f
 Vector2f CoordSpaceHelper::from_this_to_cam_space(const World& w, const Vector2f& coord) const {
     return w.drawData.cam.c.to_space(from_space(coord));
 }
+#endif
 
 CoordSpaceHelper CoordSpaceHelper::other_coord_space_to_this_space(const CoordSpaceHelper& other) const {
     CoordSpaceHelper toRet;
@@ -201,6 +299,7 @@ CoordSpaceHelper CoordSpaceHelper::other_coord_space_from_this_space(const Coord
     return toRet;
 }
 
+#ifdef IS_CLIENT
 void CoordSpaceHelper::transform_sk_canvas(SkCanvas* canvas, const DrawData& drawData) const {
     Vector2f translateSpace = -to_space(drawData.cam.c.pos);
     // NOTE: Using this commented code will lead to more accurate results with small scales, but that isn't really required in this case since that stuff just wouldn't be rendered
@@ -216,3 +315,4 @@ void CoordSpaceHelper::transform_sk_canvas(SkCanvas* canvas, const DrawData& dra
     canvas->rotate((rotation - drawData.cam.c.rotation) * 180.0 / std::numbers::pi);
     canvas->translate(translateSpace.x(), translateSpace.y());
 }
+#endif
@@ -20,6 +20,7 @@
 #include "SharedTypes.hpp"
 #include <Helpers/Serializers.hpp>
 #include <array>
+#include <span>
 #include <Helpers/SCollision.hpp>
 
 #ifndef IS_SERVER
@@ -94,6 +95,11 @@ class CoordSpaceHelper {
         }
 
         //float scalar_to_space(WorldScalar coord) const;
+        // Batched conversions. The origin is subtracted in world space, then the rotation and scale are applied as one vectorized pass
+        void to_space(std::span<const WorldVec> coords, std::span<Vector2f> out) const;
+        void from_space(std::span<const Vector2f> coords, std::span<WorldVec> out) const;
+        std::array<Vector2f, 4> aabb_corners_to_space(const SCollision::AABB<WorldScalar>& aabb) const; // In order: min, top_right, max, bottom_left
+
         std::vector<Vector2f> to_space(const std::vector<WorldVec>& coord) const;
         std::vector<WorldVec> from_space(const std::vector<Vector2f>& coord) const;
         std::vector<WorldVec> to_space_world(const std::vector<WorldVec>& coord) const;
@@ -109,14 +115,12 @@ class CoordSpaceHelper {
 
         template <size_t S> std::array<Vector2f, S> to_space(const std::array<WorldVec, S>& coord) const {
             std::array<Vector2f, S> toRet;
-            for(size_t i = 0; i < coord.size(); i++)
-                toRet[i] = to_space(coord[i]);
+            to_space(std::span<const WorldVec>(coord), std::span<Vector2f>(toRet));
             return toRet;
         }
         template <size_t S> std::array<WorldVec, S> from_space(const std::array<Vector2f, S>& coord) const {
             std::array<WorldVec, S> toRet;
-            for(size_t i = 0; i < coord.size(); i++)
-                toRet[i] = from_space(coord[i]);
+            from_space(std::span<const Vector2f>(coord), std::span<WorldVec>(toRet));
             return toRet;
         }
 
@@ -141,8 +141,8 @@ void CoordSpaceHelperTransform::translate(const WorldVec& translation) {
 
 void CoordSpaceHelperTransform::rotate_about(const WorldVec& rotatePos, double angle) {
     WorldVec a = pos - rotatePos;
-    FixedPoint::Number<boost::multiprecision::cpp_int, 15> s = FixedPoint::Number<boost::multiprecision::cpp_int, 15>(std::sin(angle));
-    FixedPoint::Number<boost::multiprecision::cpp_int, 15> c = FixedPoint::Number<boost::multiprecision::cpp_int, 15>(std::cos(angle));
+    FixedPoint::Number<WorldScalar::UnderlyingType, 15> s = FixedPoint::Number<WorldScalar::UnderlyingType, 15>(std::sin(angle));
+    FixedPoint::Number<WorldScalar::UnderlyingType, 15> c = FixedPoint::Number<WorldScalar::UnderlyingType, 15>(std::cos(angle));
     set_rotation(rotation + angle);
     pos = {
         rotatePos.x() + a.x().multiply_different_precision(c) - a.y().multiply_different_precision(s),
@@ -61,6 +61,7 @@
 
 DrawingProgram::DrawingProgram(World& initWorld):
     world(initWorld),
+    tileCache(*this),
     drawCache(*this),
     layerMan(*this),
     selection(*this)
@@ -303,7 +304,7 @@ void DrawingProgram::scale_up(const WorldScalar& scaleUpAmount) {
     layerMan.scale_up(scaleUpAmount);
     if(controls.lockedCameraScale.has_value())
         controls.lockedCameraScale.value() *= scaleUpAmount;
-    rebuild_cache();
+    drawCache.scale_up(scaleUpAmount);
 }
 
 void DrawingProgram::write_components_server(cereal::PortableBinaryOutputArchive& a) {
@@ -311,8 +312,7 @@ void DrawingProgram::write_components_server(cereal::PortableBinaryOutputArchive
 }
 
 void DrawingProgram::read_components_client(cereal::PortableBinaryInputArchive& a) {
-    layerMan.read_components_client(a);
-    drawCache.build({});
+    layerMan.read_components_client(a); // Also rebuilds the cache
 }
 
 void DrawingProgram::init_server_callbacks() {
@@ -569,8 +569,7 @@ void DrawingProgram::update() {
     update_downloading_dropped_files();
     check_updateable_components();
 
-    if(drawCache.check_rebuild_needed_from_framerate() || drawCache.should_rebuild())
-        rebuild_cache();
+    drawCache.update_bvh();
 }
 
 void DrawingProgram::pen_tool_switch_check() {
@@ -588,7 +587,7 @@ void DrawingProgram::pen_tool_switch_check() {
 
 void DrawingProgram::invalidate_cache_at_component(CanvasComponentContainer::ObjInfo* objToCheck) {
     if(!selection.is_selected(objToCheck))
-        drawCache.invalidate_cache_at_optional_aabb(objToCheck->obj->get_world_bounds());
+        drawCache.invalidate_cache_at_component(objToCheck);
 }
 
 void DrawingProgram::preupdate_component(CanvasComponentContainer::ObjInfo* objToCheck) {
@@ -823,7 +822,12 @@ void DrawingProgram::draw(SkCanvas* canvas, const DrawData& drawData) {
     else {
         canvas->saveLayer(nullptr, nullptr);
             canvas->clear(SkColor4f{0.0f, 0.0f, 0.0f, 0.0f});
-            drawCache.update_and_draw_cached_canvas(canvas, drawData);
+            if(DrawingProgramTileCache::USE_TILE_CACHE) {
+                drawCache.detach_window_cache();
+                tileCache.update_and_draw_cached_canvas(canvas, drawData);
+            }
+            else
+                drawCache.update_and_draw_cached_canvas(canvas, drawData);
             canvas->saveLayer(nullptr, nullptr);
                 selection.draw_components(canvas, drawData);
             canvas->restore();
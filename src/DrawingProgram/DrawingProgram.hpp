@@ -19,6 +19,7 @@
 #pragma once
 #include "../DrawData.hpp"
 #include "DrawingProgramCache.hpp"
+#include "DrawingProgramTileCache.hpp"
 #include "ToolConfiguration.hpp"
 #include "Tools/GridModifyTool.hpp"
 #include <Helpers/NetworkingObjects/NetObjWeakPtr.hpp>
@@ -68,6 +69,7 @@ class DrawingProgram {
 
         bool prevent_undo_or_redo();
 
+        DrawingProgramTileCache tileCache; // Before drawCache, since drawCache clears its tiles when destroyed
         DrawingProgramCache drawCache;
         DrawingProgramLayerManager layerMan;
 
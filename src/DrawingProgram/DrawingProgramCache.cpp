@@ -20,8 +20,13 @@
 #include "DrawingProgram.hpp"
 #include "../World.hpp"
 #include "../MainProgram.hpp"
+#include "../RenderStats.hpp"
 #include "Helpers/Parallel.hpp"
 #include "Layers/DrawingProgramLayerManager.hpp"
+#include <Helpers/Logger.hpp>
+#include <bit>
+#include <span>
+#include <thread>
 
 #ifdef USE_SKIA_BACKEND_GRAPHITE
     #include <include/gpu/graphite/Surface.h>
@@ -30,18 +35,80 @@
     #include <include/gpu/ganesh/SkSurfaceGanesh.h>
 #endif
 
-size_t DrawingProgramCache::MINIMUM_COMPONENTS_TO_START_REBUILD = 1000;
 size_t DrawingProgramCache::MAXIMUM_COMPONENTS_IN_SINGLE_NODE = 50;
 #ifdef __EMSCRIPTEN__
-    size_t DrawingProgramCache::MAXIMUM_DRAW_CACHE_SURFACES = 40; // Use less VRAM in web build
+    size_t DrawingProgramCache::DRAW_CACHE_MEMORY_BUDGET_MB = 640; // Use less VRAM in web build
 #else
-    size_t DrawingProgramCache::MAXIMUM_DRAW_CACHE_SURFACES = 96;
+    size_t DrawingProgramCache::DRAW_CACHE_MEMORY_BUDGET_MB = 1536;
 #endif
 size_t DrawingProgramCache::CACHE_NODE_RESOLUTION = 2048;
-size_t DrawingProgramCache::MILLISECOND_FRAME_TIME_TO_FORCE_CACHE_REFRESH = 33; // Around 30FPS
-size_t DrawingProgramCache::MILLISECOND_MINIMUM_TIME_TO_CHECK_FORCE_REFRESH = 5000; // Should be a bit long to prevent objects that are being updated, like brush strokes, from constantly refreshing the cache.
+size_t DrawingProgramCache::CACHE_REFRESH_BUDGET_MILLISECONDS = 8;
+bool DrawingProgramCache::USE_SAH_BVH_BUILDER = true;
+bool DrawingProgramCache::USE_OCCLUSION_CULLING = true;
+size_t DrawingProgramCache::MAXIMUM_CACHED_LAYERS = 4;
+
+// Components wider or taller than this fraction of the node being split stay in that node (up to MAXIMUM_COMPONENTS_IN_SINGLE_NODE of them), since they would stretch the bounds of any child they're placed in
+static constexpr double SAH_LARGE_COMPONENT_FRACTION = 0.5;
+static constexpr size_t SAH_BIN_COUNT = 16;
+// Size of the view querying the tree, relative to the node being split. A node is drawn uncached when the view overlaps it, which happens with probability proportional to the area of the node grown by the view size
+static constexpr double SAH_VIEW_SIZE = 0.05;
+
+// Layers with fewer components than this are cheap enough to draw from their components
+static constexpr uint32_t LAYER_CACHE_MINIMUM_COMPONENT_COUNT = 500;
+
+// While zooming, the previous window cache is drawn scaled up to this much instead of being redrawn, until the camera stops moving
+static constexpr double WINDOW_CACHE_MAXIMUM_ZOOM_PREVIEW_MAGNIFICATION = 2.0;
+
+// Order of the components in a node. Components are grouped by layer, and are in draw order within each layer. Inserting or
+// erasing other components in a layer changes their positions, but not their order, so nodes only have to be reordered when a component is moved
+static bool component_draw_order_less(const CanvasComponentContainer::ObjInfo* a, const CanvasComponentContainer::ObjInfo* b) {
+    if(a->obj->parentLayer != b->obj->parentLayer)
+        return std::less<const DrawingProgramLayerListItem*>()(a->obj->parentLayer, b->obj->parentLayer);
+    return a->pos < b->pos;
+}
+
+static void insert_component_in_draw_order(std::vector<CanvasComponentContainer::ObjInfo*>& components, CanvasComponentContainer::ObjInfo* c) {
+    components.insert(std::upper_bound(components.begin(), components.end(), c, component_draw_order_less), c);
+}
+
+// The components of a node that are in this layer, in draw order
+static std::span<CanvasComponentContainer::ObjInfo* const> get_layer_components_in_draw_order(const std::vector<CanvasComponentContainer::ObjInfo*>& components, const DrawingProgramLayerListItem* layer) {
+    auto layerLess = std::less<const DrawingProgramLayerListItem*>();
+    auto begin = std::lower_bound(components.begin(), components.end(), layer, [&](const CanvasComponentContainer::ObjInfo* c, const DrawingProgramLayerListItem* l) {
+        return layerLess(c->obj->parentLayer, l);
+    });
+    auto end = std::upper_bound(begin, components.end(), layer, [&](const DrawingProgramLayerListItem* l, const CanvasComponentContainer::ObjInfo* c) {
+        return layerLess(l, c->obj->parentLayer);
+    });
+    return {begin, end};
+}
+
+// Every component drawn is tested against every occluder, so only the frontmost few opaque components are used
+static constexpr size_t OCCLUSION_MAXIMUM_OCCLUDERS = 8;
+
+// Goes through the components front to back, and erases the ones completely under an opaque component drawn after them
+static void erase_occluded_components(std::vector<CanvasComponentContainer::ObjInfo*>& compsInDrawOrder, const DrawData& drawData) {
+    std::vector<SCollision::AABB<WorldScalar>> occluders;
+    size_t firstKept = compsInDrawOrder.size();
+    for(size_t i = compsInDrawOrder.size(); i-- > 0;) {
+        CanvasComponentContainer::ObjInfo* c = compsInDrawOrder[i];
+        const SCollision::AABB<WorldScalar>& cBounds = c->obj->get_world_bounds().value();
+        if(std::ranges::any_of(occluders, [&](const SCollision::AABB<WorldScalar>& occluder) { return occluder.fully_contains_aabb(cBounds); }))
+            continue;
+        compsInDrawOrder[--firstKept] = c;
+        if(occluders.size() < OCCLUSION_MAXIMUM_OCCLUDERS) {
+            std::optional<SCollision::AABB<WorldScalar>> opaqueBounds = c->obj->get_opaque_world_bounds(drawData);
+            if(opaqueBounds.has_value())
+                occluders.emplace_back(opaqueBounds.value());
+        }
+    }
+    compsInDrawOrder.erase(compsInDrawOrder.begin(), compsInDrawOrder.begin() + firstKept);
+}
 
 std::unordered_map<std::shared_ptr<DrawingProgramCacheBVHNode>, DrawingProgramCache::NodeCache> DrawingProgramCache::nodeCacheMap;
+DrawingProgramCache::NodeCacheMapEntry* DrawingProgramCache::nodeCacheLRUFront = nullptr;
+DrawingProgramCache::NodeCacheMapEntry* DrawingProgramCache::nodeCacheLRUBack = nullptr;
+DrawingProgramCache::NodeCacheStats DrawingProgramCache::nodeCacheStats;
 DrawingProgramCache::WindowCache DrawingProgramCache::windowCache;
 
 DrawingProgramCache::DrawingProgramCache(DrawingProgram& initDrawP):
@@ -50,7 +117,8 @@ DrawingProgramCache::DrawingProgramCache(DrawingProgram& initDrawP):
 
 void DrawingProgramCache::add_component(CanvasComponentContainer::ObjInfo* c) {
     unsortedComponents.emplace_back(c);
-    invalidate_cache_at_optional_aabb(c->obj->get_world_bounds());
+    mark_component_changed_since_snapshot(c, true);
+    invalidate_cache_at_component(c);
 }
 
 void DrawingProgramCache::erase_component(CanvasComponentContainer::ObjInfo* c) {
@@ -58,15 +126,41 @@ void DrawingProgramCache::erase_component(CanvasComponentContainer::ObjInfo* c)
     if(cacheParentBvhNodeLock) {
         std::erase(cacheParentBvhNodeLock->components, c);
         c->obj->cacheParentBvhNode.reset();
+        nodesToRefit.emplace_back(cacheParentBvhNodeLock);
     }
     else
         std::erase(unsortedComponents, c);
-    invalidate_cache_at_optional_aabb(c->obj->get_world_bounds());
+    mark_component_changed_since_snapshot(c, false);
+    invalidate_cache_at_component(c);
+}
+
+void DrawingProgramCache::mark_component_changed_since_snapshot(CanvasComponentContainer::ObjInfo* c, std::optional<bool> isInCache) {
+    if(pendingBuild) {
+        if(isInCache.has_value())
+            pendingBuild->componentsChangedSinceSnapshot[c] = isInCache;
+        else
+            pendingBuild->componentsChangedSinceSnapshot.try_emplace(c, std::nullopt);
+    }
 }
 
 void DrawingProgramCache::invalidate_cache_at_aabb(const SCollision::AABB<WorldScalar>& aabb) {
-    for(auto& [node, nodeCache] : nodeCacheMap) {
-        if(nodeCache.attachedDrawingProgramCache == this && SCollision::collide(aabb, node->bounds)) {
+    invalidate_cache_at_aabb_in_layer(aabb, nullptr);
+}
+
+void DrawingProgramCache::invalidate_cache_at_component(CanvasComponentContainer::ObjInfo* c) {
+    std::optional<SCollision::AABB<WorldScalar>> aabb = c->obj->get_world_bounds();
+    if(aabb.has_value())
+        invalidate_cache_at_aabb_in_layer(aabb.value(), c->obj->parentLayer);
+}
+
+void DrawingProgramCache::invalidate_cache_at_aabb_in_layer(const SCollision::AABB<WorldScalar>& aabb, const DrawingProgramLayerListItem* layer) {
+    // Every node cached by this DrawingProgramCache is in its tree, so only the branches colliding with the AABB that have cached nodes need to be visited
+    traverse_bvh_run_function_starting_at_node(bvhRoot, aabb, [&](const std::shared_ptr<DrawingProgramCacheBVHNode>& node) {
+        if(node->cachedNodeCount == 0)
+            return false;
+        auto it = nodeCacheMap.find(node);
+        if(it != nodeCacheMap.end()) {
+            auto& nodeCache = it->second;
             if(nodeCache.invalidBounds.has_value()) {
                 auto& iBounds = nodeCache.invalidBounds.value();
                 iBounds.include_aabb_in_bounds(aabb);
@@ -74,7 +168,8 @@ void DrawingProgramCache::invalidate_cache_at_aabb(const SCollision::AABB<WorldS
             else
                 nodeCache.invalidBounds = aabb;
         }
-    }
+        return true;
+    });
     if(SCollision::collide(aabb, drawP.world.drawData.cam.viewingAreaGenerousCollider)) {
         if(windowCache.invalidBounds.has_value()) {
             auto& iBounds = windowCache.invalidBounds.value();
@@ -82,7 +177,18 @@ void DrawingProgramCache::invalidate_cache_at_aabb(const SCollision::AABB<WorldS
         }
         else
             windowCache.invalidBounds = aabb;
+        if(windowCache.attachedDrawingProgramCache == this) {
+            for(auto& [layerCacheLayer, layerCache] : windowCache.layerCaches) {
+                if(!layer || layerCacheLayer == layer) {
+                    if(layerCache.invalidBounds.has_value())
+                        layerCache.invalidBounds.value().include_aabb_in_bounds(aabb);
+                    else
+                        layerCache.invalidBounds = aabb;
+                }
+            }
+        }
     }
+    drawP.tileCache.invalidate_cache_at_aabb(aabb);
 }
 
 void DrawingProgramCache::invalidate_cache_at_optional_aabb(const std::optional<SCollision::AABB<WorldScalar>>& aabb) {
@@ -90,57 +196,334 @@ void DrawingProgramCache::invalidate_cache_at_optional_aabb(const std::optional<
         invalidate_cache_at_aabb(aabb.value());
 }
 
-bool DrawingProgramCache::should_rebuild() const {
-    return (unsortedComponents.size() >= MINIMUM_COMPONENTS_TO_START_REBUILD);
-}
-
-bool DrawingProgramCache::check_rebuild_needed_from_framerate() {
-    if(drawP.world.main.window.lastFrameTime > std::chrono::milliseconds(MILLISECOND_FRAME_TIME_TO_FORCE_CACHE_REFRESH)) {
-        if(!badFrametimeTimePoint)
-            badFrametimeTimePoint = std::chrono::steady_clock::now();
-        else if(unorderedObjectsExistTimePoint && std::chrono::steady_clock::now() - badFrametimeTimePoint.value() >= std::chrono::milliseconds(MILLISECOND_MINIMUM_TIME_TO_CHECK_FORCE_REFRESH) && std::chrono::steady_clock::now() - unorderedObjectsExistTimePoint.value() >= std::chrono::milliseconds(MILLISECOND_MINIMUM_TIME_TO_CHECK_FORCE_REFRESH)) {
-            unorderedObjectsExistTimePoint = std::nullopt;
-            badFrametimeTimePoint = std::nullopt;
+void DrawingProgramCache::build(const std::unordered_set<CanvasComponentContainer::ObjInfo*>& objsToExclude) {
+    auto job = std::make_shared<BVHBuildJob>();
+    job->settings = get_build_settings();
+    auto componentsToBuild = drawP.layerMan.get_flattened_component_list();
+    std::erase_if(componentsToBuild, [&job, &objsToExclude](auto& c) {
+        if(objsToExclude.contains(c))
+            return true;
+        if(!c->obj->get_world_bounds().has_value()) {
+            job->componentsWithoutBounds.emplace_back(c);
             return true;
         }
+        return false;
+    });
+    job->components = get_build_components(componentsToBuild);
+
+    // A build that's still running is abandoned. The worker keeps its own reference to the job, so it can stop without us waiting on it
+    cancel_pending_build();
+    pendingBuild = job;
+    {
+        std::scoped_lock lock(buildWorkerMutex);
+        queuedBuild = job;
     }
-    else
-        badFrametimeTimePoint = std::nullopt;
+    if(!buildWorker.joinable())
+        buildWorker = std::thread(&DrawingProgramCache::build_worker_func, this);
+    buildQueuedCV.notify_one();
+}
 
-    if(unsortedComponents.empty())
-        unorderedObjectsExistTimePoint = std::nullopt;
-    else if(!unorderedObjectsExistTimePoint)
-        unorderedObjectsExistTimePoint = std::chrono::steady_clock::now();
+void DrawingProgramCache::build_worker_func() {
+    std::unique_lock lock(buildWorkerMutex);
+    for(;;) {
+        buildQueuedCV.wait(lock, [&] { return buildWorkerShutdown || queuedBuild; });
+        if(buildWorkerShutdown)
+            return;
+        std::shared_ptr<BVHBuildJob> job = std::move(queuedBuild);
+        queuedBuild = nullptr;
 
-    return false;
+        lock.unlock();
+        if(!job->cancelled)
+            build_bvh_job(*job);
+        lock.lock();
+    }
 }
 
-void DrawingProgramCache::build(const std::unordered_set<CanvasComponentContainer::ObjInfo*>& objsToExclude) {
-    internal_build(drawP.layerMan.get_flattened_component_list(), objsToExclude);
+void DrawingProgramCache::build_bvh_job(BVHBuildJob& job) {
+    // Runs on the worker thread. Only reads the snapshot, so the components can be changed or deleted while this runs
+    job.root = std::make_shared<DrawingProgramCacheBVHNode>();
+    build_bvh_node(job.root, get_build_component_pointers(job.components), job.settings, job.placements, &job.cancelled);
+    job.finished = true;
+}
+
+void DrawingProgramCache::cancel_pending_build() {
+    if(pendingBuild) {
+        pendingBuild->cancelled = true;
+        pendingBuild = nullptr;
+    }
 }
 
-void DrawingProgramCache::internal_build(std::vector<CanvasComponentContainer::ObjInfo*> componentsToBuild, const std::unordered_set<CanvasComponentContainer::ObjInfo*>& objsToNotInclude) {
-    bvhRoot = std::make_shared<DrawingProgramCacheBVHNode>();
+DrawingProgramCache::BVHBuildSettings DrawingProgramCache::get_build_settings() {
+    return {USE_SAH_BVH_BUILDER, MAXIMUM_COMPONENTS_IN_SINGLE_NODE, CACHE_NODE_RESOLUTION};
+}
+
+void DrawingProgramCache::clear_bvh() {
+    cancel_pending_build();
+    bvhRoot = nullptr;
     unsortedComponents.clear();
-    std::erase_if(componentsToBuild, [&unsortedComponents = unsortedComponents, &objsToNotInclude](auto& c) {
-        if(objsToNotInclude.contains(c))
-            return true;
-        if(!c->obj->get_world_bounds().has_value()) {
-            unsortedComponents.emplace_back(c);
+    nodesToRefit.clear();
+    nodesToSort.clear();
+    clear_own_cached_surfaces();
+}
+
+void DrawingProgramCache::swap_in_built_bvh() {
+    std::shared_ptr<BVHBuildJob> job = std::move(pendingBuild);
+    pendingBuild = nullptr;
+    auto& changedComponents = job->componentsChangedSinceSnapshot;
+
+    if(job->scaleUpAmountSinceSnapshot.has_value()) {
+        traverse_bvh_run_function_starting_at_node_no_collision_check(job->root, [&](const std::shared_ptr<DrawingProgramCacheBVHNode>& node) {
+            scale_up_bvh_node(*node, job->scaleUpAmountSinceSnapshot.value());
             return true;
+        });
+    }
+
+    // Components changed since the snapshot are taken out of the new tree. The ones still in the cache are inserted again through unsortedComponents
+    std::unordered_set<CanvasComponentContainer::ObjInfo*> changedComponentsInSnapshot;
+    std::vector<CanvasComponentContainer::ObjInfo*> newUnsortedComponents;
+    std::vector<std::weak_ptr<DrawingProgramCacheBVHNode>> newNodesToRefit;
+    for(auto& placement : job->placements) {
+        if(!changedComponents.contains(placement.comp)) {
+            placement.comp->obj->cacheParentBvhNode = placement.node;
+            placement.comp->obj->cacheParentBvhNodeRelativeCoords = placement.relativeCoords;
         }
-        return false;
+        else {
+            std::erase(placement.node->components, placement.comp);
+            newNodesToRefit.emplace_back(placement.node);
+            changedComponentsInSnapshot.emplace(placement.comp);
+        }
+    }
+    for(auto& c : job->componentsWithoutBounds) {
+        if(!changedComponents.contains(c))
+            newUnsortedComponents.emplace_back(c);
+        else
+            changedComponentsInSnapshot.emplace(c);
+    }
+    for(auto& [c, isInCache] : changedComponents) {
+        // Components that were erased might be deleted already, so they're only dereferenced if they're known to still be in the cache
+        bool stillInCache = isInCache.has_value() ? isInCache.value() : (changedComponentsInSnapshot.contains(c) || !c->obj->cacheParentBvhNode.expired() || std::find(unsortedComponents.begin(), unsortedComponents.end(), c) != unsortedComponents.end());
+        if(stillInCache) {
+            c->obj->cacheParentBvhNode.reset();
+            newUnsortedComponents.emplace_back(c);
+        }
+    }
+
+    carry_over_node_caches(job->root);
+    bvhRoot = job->root;
+    unsortedComponents = std::move(newUnsortedComponents);
+    nodesToRefit = std::move(newNodesToRefit);
+}
+
+void DrawingProgramCache::carry_over_node_caches(const std::shared_ptr<DrawingProgramCacheBVHNode>& newRoot) {
+    // A cached surface shows everything inside its node's bounds, so it can be reused by a node in the new tree with the same bounds and resolution
+    std::vector<std::shared_ptr<DrawingProgramCacheBVHNode>> oldNodes;
+    std::vector<std::pair<std::shared_ptr<DrawingProgramCacheBVHNode>, NodeCache>> carriedOverCaches;
+    for(auto& [oldNode, nodeCache] : nodeCacheMap) {
+        if(nodeCache.attachedDrawingProgramCache != this)
+            continue;
+        std::shared_ptr<DrawingProgramCacheBVHNode> node = newRoot;
+        while(node && !(node->bounds == oldNode->bounds && node->resolution == oldNode->resolution)) {
+            auto childIt = std::find_if(node->children.begin(), node->children.end(), [&](const auto& child) {
+                return child->bounds.fully_contains_aabb(oldNode->bounds);
+            });
+            node = childIt == node->children.end() ? nullptr : *childIt;
+        }
+        if(node)
+            carriedOverCaches.emplace_back(node, nodeCache);
+        oldNodes.emplace_back(oldNode);
+    }
+    for(auto& oldNode : oldNodes)
+        erase_node_cache(oldNode);
+    for(auto& [node, nodeCache] : carriedOverCaches)
+        emplace_node_cache(node, nodeCache);
+}
+
+void DrawingProgramCache::scale_up(const WorldScalar& scaleUpAmount) {
+    // Every coordinate is multiplied by the same amount, so the tree's structure and the component coordinates relative to each node stay the same
+    traverse_bvh_run_function_starting_at_node_no_collision_check(bvhRoot, [&](const std::shared_ptr<DrawingProgramCacheBVHNode>& node) {
+        scale_up_bvh_node(*node, scaleUpAmount);
+        return true;
     });
-    clear_own_cached_surfaces();
-    build_bvh_node(bvhRoot, componentsToBuild);
+    for(auto& [node, nodeCache] : nodeCacheMap) {
+        if(nodeCache.attachedDrawingProgramCache == this && nodeCache.invalidBounds.has_value()) {
+            nodeCache.invalidBounds.value().min *= scaleUpAmount;
+            nodeCache.invalidBounds.value().max *= scaleUpAmount;
+        }
+    }
+    if(windowCache.attachedDrawingProgramCache == this) {
+        windowCache.coords.scale_about(WorldVec{0, 0}, scaleUpAmount, true);
+        windowCache.lastFrameCamCoords.scale_about(WorldVec{0, 0}, scaleUpAmount, true);
+        if(windowCache.invalidBounds.has_value()) {
+            windowCache.invalidBounds.value().min *= scaleUpAmount;
+            windowCache.invalidBounds.value().max *= scaleUpAmount;
+        }
+    }
+    // Tiles sit on a power of two grid, and the scale up amount isn't a power of two, so the tiles don't line up with the grid anymore
+    drawP.tileCache.clear_own_tiles();
+    if(pendingBuild) {
+        auto& pendingScaleUpAmount = pendingBuild->scaleUpAmountSinceSnapshot;
+        pendingScaleUpAmount = pendingScaleUpAmount.has_value() ? pendingScaleUpAmount.value() * scaleUpAmount : scaleUpAmount;
+    }
 }
 
-void DrawingProgramCache::clear_own_cached_surfaces() {
-    std::erase_if(nodeCacheMap, [&](auto& nodeCachePair) {
-        return nodeCachePair.second.attachedDrawingProgramCache == this;
+void DrawingProgramCache::scale_up_bvh_node(DrawingProgramCacheBVHNode& node, const WorldScalar& scaleUpAmount) {
+    node.bounds.min *= scaleUpAmount;
+    node.bounds.max *= scaleUpAmount;
+    node.coords.scale_about(WorldVec{0, 0}, scaleUpAmount, true);
+}
+
+void DrawingProgramCache::update_bvh() {
+    if(pendingBuild && pendingBuild->finished)
+        swap_in_built_bvh();
+    sort_moved_bvh_nodes(); // Before inserting, since inserting needs the nodes to be in draw order
+    std::erase_if(unsortedComponents, [&](auto& c) {
+        if(!c->obj->get_world_bounds().has_value())
+            return false;
+        insert_component_into_bvh(c);
+        return true;
     });
-    if(windowCache.attachedDrawingProgramCache == this) // Don't delete the cache surface. We don't have to reallocate it if the window size didn't change
+    refit_bvh_nodes();
+}
+
+void DrawingProgramCache::insert_component_into_bvh(CanvasComponentContainer::ObjInfo* c) {
+    // Node bounds are never changed after a node is built, since that would invalidate the node's cached surface.
+    // Instead, the component is placed in the deepest node that already fully contains it
+    const auto& cAABB = c->obj->get_world_bounds().value();
+
+    if(!bvhRoot || (bvhRoot->components.empty() && bvhRoot->children.empty())) {
+        if(bvhRoot)
+            erase_node_cache(bvhRoot);
+        bvhRoot = std::make_shared<DrawingProgramCacheBVHNode>();
+        auto buildComponents = get_build_components({c});
+        std::vector<BVHComponentPlacement> placements;
+        build_bvh_node(bvhRoot, get_build_component_pointers(buildComponents), get_build_settings(), placements);
+        apply_component_placements(placements);
+        return;
+    }
+
+    if(!bvhRoot->bounds.fully_contains_aabb(cAABB))
+        grow_bvh_root(cAABB);
+
+    std::shared_ptr<DrawingProgramCacheBVHNode> node = bvhRoot;
+    for(;;) {
+        auto childIt = std::find_if(node->children.begin(), node->children.end(), [&](const auto& child) {
+            return child->bounds.fully_contains_aabb(cAABB);
+        });
+        if(childIt == node->children.end())
+            break;
+        node = *childIt;
+    }
+
+    insert_component_in_draw_order(node->components, c);
+    set_component_parent_node(c, node);
+
+    // Allow nodes to grow past the build limit before splitting, so that a node near the limit isn't split on every insert
+    if(node->components.size() >= 2 * MAXIMUM_COMPONENTS_IN_SINGLE_NODE)
+        split_bvh_node_components(node);
+}
+
+void DrawingProgramCache::grow_bvh_root(const SCollision::AABB<WorldScalar>& aabbToInclude) {
+    SCollision::AABB<WorldScalar> newBounds = bvhRoot->bounds;
+    newBounds.include_aabb_in_bounds(aabbToInclude);
+    // Leave extra space, so that drawing outwards doesn't add a new root for every component
+    WorldVec extraSpace = newBounds.dim() / WorldScalar(2);
+    newBounds.min -= extraSpace;
+    newBounds.max += extraSpace;
+
+    auto newRoot = std::make_shared<DrawingProgramCacheBVHNode>();
+    newRoot->bounds = newBounds;
+    build_bvh_node_coords_and_resolution(*newRoot, CACHE_NODE_RESOLUTION);
+    newRoot->children.emplace_back(bvhRoot);
+    newRoot->cachedNodeCount = bvhRoot->cachedNodeCount;
+    bvhRoot->parent = newRoot;
+    bvhRoot = newRoot;
+}
+
+void DrawingProgramCache::split_bvh_node_components(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode) {
+    // Only this node's own components are moved into new children. The node's bounds and existing children stay the same, so their cached surfaces are still valid
+    auto buildComponents = get_build_components(bvhNode->components);
+    bvhNode->components.clear();
+
+    std::vector<const BVHBuildComponent*> componentsToKeep;
+    std::vector<std::vector<const BVHBuildComponent*>> parts;
+    BVHBuildSettings settings = get_build_settings();
+    if(settings.useSAH)
+        split_components_sah(*bvhNode, get_build_component_pointers(buildComponents), settings.maxComponentsInSingleNode, componentsToKeep, parts);
+    else
+        split_components_quadtree(*bvhNode, get_build_component_pointers(buildComponents), componentsToKeep, parts);
+
+    std::vector<BVHComponentPlacement> placements;
+    add_components_to_node_in_draw_order(bvhNode, std::move(componentsToKeep), placements);
+    for(auto& p : parts) {
+        if(!p.empty()) {
+            auto& child = bvhNode->children.emplace_back(std::make_shared<DrawingProgramCacheBVHNode>());
+            child->parent = bvhNode;
+            build_bvh_node(child, p, settings, placements);
+        }
+    }
+    apply_component_placements(placements);
+}
+
+void DrawingProgramCache::sort_moved_bvh_nodes() {
+    // Positions are all final by now. Nodes from a tree that was swapped out have expired, and the swapped in tree took moved components out
+    for(auto& nodeToSort : nodesToSort) {
+        std::shared_ptr<DrawingProgramCacheBVHNode> node = nodeToSort.lock();
+        if(node && !std::is_sorted(node->components.begin(), node->components.end(), component_draw_order_less)) // Already sorted if it's listed more than once
+            std::sort(node->components.begin(), node->components.end(), component_draw_order_less);
+    }
+    nodesToSort.clear();
+}
+
+void DrawingProgramCache::refit_bvh_nodes() {
+    // Removes nodes that were emptied, and collapses nodes that only have a single child left
+    for(auto& nodeToRefit : nodesToRefit) {
+        std::shared_ptr<DrawingProgramCacheBVHNode> node = nodeToRefit.lock();
+        while(node && node->components.empty() && node->children.size() <= 1) {
+            std::shared_ptr<DrawingProgramCacheBVHNode> replacement = node->children.empty() ? nullptr : node->children.front();
+            std::shared_ptr<DrawingProgramCacheBVHNode> parent = node->parent.lock();
+            if(parent) {
+                auto it = std::find(parent->children.begin(), parent->children.end(), node);
+                if(it == parent->children.end()) // Already removed from the tree
+                    break;
+                if(replacement) {
+                    *it = replacement;
+                    replacement->parent = parent;
+                }
+                else
+                    parent->children.erase(it);
+            }
+            else if(node == bvhRoot && replacement) {
+                bvhRoot = replacement;
+                replacement->parent.reset();
+            }
+            else // Empty root, or node no longer in the tree
+                break;
+            erase_node_cache(node);
+            node->children.clear();
+            node = parent;
+        }
+    }
+    nodesToRefit.clear();
+}
+
+void DrawingProgramCache::clear_own_cached_surfaces() {
+    std::vector<std::shared_ptr<DrawingProgramCacheBVHNode>> ownNodes;
+    for(auto& [node, nodeCache] : nodeCacheMap) {
+        if(nodeCache.attachedDrawingProgramCache == this)
+            ownNodes.emplace_back(node);
+    }
+    for(auto& node : ownNodes)
+        erase_node_cache(node);
+    detach_window_cache();
+    drawP.tileCache.clear_own_tiles();
+}
+
+void DrawingProgramCache::detach_window_cache() {
+    if(windowCache.attachedDrawingProgramCache == this) { // Don't delete the cache surface. We don't have to reallocate it if the window size didn't change
         windowCache.attachedDrawingProgramCache = nullptr;
+        windowCache.layerCaches.clear(); // Layers could be erased while detached
+        windowCache.layerCachesValid = false;
+    }
 }
 
 CanvasComponentContainer::ObjInfo* DrawingProgramCache::get_front_object_colliding_with_in_editing_layer(const SkPath& cC) {
@@ -156,25 +539,11 @@ CanvasComponentContainer::ObjInfo* DrawingProgramCache::get_front_object_collidi
     return p;
 }
 
-void DrawingProgramCache::node_loop_erase_if_components(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, std::function<bool(CanvasComponentContainer::ObjInfo* comp)> f) {
-    if(bvhNode) {
-        std::erase_if(bvhNode->components, [&f](const auto& comp) {
-            if(f(comp)) {
-                comp->obj->cacheParentBvhNode.reset();
-                return true;
-            }
-            return false;
-        });
-    }
-    else
-        std::erase_if(unsortedComponents, f);
-}
-
-void DrawingProgramCache::node_loop_components(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, std::function<void(CanvasComponentContainer::ObjInfo* comp)> f) {
-    if(bvhNode)
-        std::for_each(bvhNode->components.begin(), bvhNode->components.end(), f);
-    else
-        std::for_each(unsortedComponents.begin(), unsortedComponents.end(), f);
+void DrawingProgramCache::update_component_draw_order(CanvasComponentContainer::ObjInfo* c) {
+    auto cacheParentBvhNodeLock = c->obj->cacheParentBvhNode.lock();
+    if(cacheParentBvhNodeLock)
+        nodesToSort.emplace_back(cacheParentBvhNodeLock);
+    mark_component_changed_since_snapshot(c, std::nullopt); // The pending build's snapshot has the old draw order
 }
 
 void DrawingProgramCache::preupdate_component(CanvasComponentContainer::ObjInfo* c) {
@@ -184,33 +553,49 @@ void DrawingProgramCache::preupdate_component(CanvasComponentContainer::ObjInfo*
         unsortedComponents.emplace_back(c);
         std::erase(cacheParentBvhNodeLock->components, c);
         c->obj->cacheParentBvhNode.reset();
+        nodesToRefit.emplace_back(cacheParentBvhNodeLock);
     }
-    invalidate_cache_at_optional_aabb(c->obj->get_world_bounds());
+    mark_component_changed_since_snapshot(c, std::nullopt);
+    invalidate_cache_at_component(c);
 }
 
-void DrawingProgramCache::build_bvh_node(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, const std::vector<CanvasComponentContainer::ObjInfo*>& components) {
-    if(components.empty())
+void DrawingProgramCache::build_bvh_node(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, const std::vector<const BVHBuildComponent*>& components, const BVHBuildSettings& settings, std::vector<BVHComponentPlacement>& placements, const std::atomic<bool>* cancelled) {
+    if(components.empty() || (cancelled && *cancelled))
         return;
 
-    bvhNode->bounds = components.front()->obj->get_world_bounds().value();
+    bvhNode->bounds = components.front()->bounds;
     for(auto& c : components)
-        bvhNode->bounds.include_aabb_in_bounds(c->obj->get_world_bounds().value());
+        bvhNode->bounds.include_aabb_in_bounds(c->bounds);
 
-    build_bvh_node_coords_and_resolution(*bvhNode);
+    build_bvh_node_coords_and_resolution(*bvhNode, settings.nodeResolution);
 
-    if(components.size() < MAXIMUM_COMPONENTS_IN_SINGLE_NODE) {
-        bvhNode->components = components;
-        for(auto& c : bvhNode->components)
-            c->obj->cacheParentBvhNode = bvhNode;
-        return;
+    std::vector<const BVHBuildComponent*> componentsToKeep;
+    std::vector<std::vector<const BVHBuildComponent*>> parts;
+    if(components.size() < settings.maxComponentsInSingleNode)
+        componentsToKeep = components;
+    else if(settings.useSAH)
+        split_components_sah(*bvhNode, components, settings.maxComponentsInSingleNode, componentsToKeep, parts);
+    else
+        split_components_quadtree(*bvhNode, components, componentsToKeep, parts);
+
+    add_components_to_node_in_draw_order(bvhNode, std::move(componentsToKeep), placements);
+
+    for(auto& p : parts) {
+        if(!p.empty()) {
+            auto& child = bvhNode->children.emplace_back(std::make_shared<DrawingProgramCacheBVHNode>());
+            child->parent = bvhNode;
+            build_bvh_node(child, p, settings, placements, cancelled);
+        }
     }
+}
 
-    WorldVec boundsCenter = bvhNode->bounds.center();
+void DrawingProgramCache::split_components_quadtree(DrawingProgramCacheBVHNode& node, const std::vector<const BVHBuildComponent*>& components, std::vector<const BVHBuildComponent*>& componentsToKeep, std::vector<std::vector<const BVHBuildComponent*>>& parts) {
+    WorldVec boundsCenter = node.bounds.center();
 
-    std::array<std::vector<CanvasComponentContainer::ObjInfo*>, 4> parts;
+    parts.resize(4);
 
     for(auto& c : components) {
-        const auto& cAABB = c->obj->get_world_bounds().value();
+        const auto& cAABB = c->bounds;
         if(cAABB.min.x() < boundsCenter.x() && cAABB.max.x() < boundsCenter.x() && cAABB.min.y() < boundsCenter.y() && cAABB.max.y() < boundsCenter.y())
             parts[0].emplace_back(c);
         else if(cAABB.min.x() > boundsCenter.x() && cAABB.max.x() > boundsCenter.x() && cAABB.min.y() < boundsCenter.y() && cAABB.max.y() < boundsCenter.y())
@@ -219,31 +604,245 @@ void DrawingProgramCache::build_bvh_node(const std::shared_ptr<DrawingProgramCac
             parts[2].emplace_back(c);
         else if(cAABB.min.x() > boundsCenter.x() && cAABB.max.x() > boundsCenter.x() && cAABB.min.y() > boundsCenter.y() && cAABB.max.y() > boundsCenter.y())
             parts[3].emplace_back(c);
-        else {
-            bvhNode->components.emplace_back(c);
-            c->obj->cacheParentBvhNode = bvhNode;
+        else
+            componentsToKeep.emplace_back(c);
+    }
+}
+
+struct SAHBuildItem {
+    size_t componentIndex; // Index into the components being split
+    SCollision::AABB<double> bounds; // Relative to the node being split
+};
+
+static double sah_view_overlap_cost(const SCollision::AABB<double>& a, size_t count) {
+    return (a.width() + SAH_VIEW_SIZE) * (a.height() + SAH_VIEW_SIZE) * static_cast<double>(count);
+}
+
+static size_t sah_bin_index(const SAHBuildItem& item, int axis, double axisMin, double axisLength) {
+    double t = (item.bounds.center()[axis] - axisMin) / axisLength;
+    return std::min(static_cast<size_t>(std::max(t, 0.0) * SAH_BIN_COUNT), SAH_BIN_COUNT - 1);
+}
+
+// Reorders items into two non empty groups, and returns the size of the first group. Items are binned by their center along
+// each axis, and the split between bins with the lowest cost is chosen
+static size_t sah_partition(std::span<SAHBuildItem> items) {
+    struct Bin {
+        size_t count = 0;
+        SCollision::AABB<double> bounds;
+    };
+
+    auto include_in_bin = [](Bin& bin, const SCollision::AABB<double>& bounds, size_t count) {
+        if(count == 0)
+            return;
+        if(bin.count == 0)
+            bin.bounds = bounds;
+        else
+            bin.bounds.include_aabb_in_bounds(bounds);
+        bin.count += count;
+    };
+
+    SCollision::AABB<double> centerBounds{items.front().bounds.center(), items.front().bounds.center()};
+    for(auto& item : items)
+        centerBounds.include_point_in_bounds(item.bounds.center());
+
+    double bestCost = std::numeric_limits<double>::max();
+    std::optional<int> bestAxis;
+    size_t bestBin = 0;
+
+    for(int axis = 0; axis < 2; axis++) {
+        double axisMin = centerBounds.min[axis];
+        double axisLength = centerBounds.max[axis] - axisMin;
+        if(!(axisLength > 0.0))
+            continue;
+
+        std::array<Bin, SAH_BIN_COUNT> bins;
+        for(auto& item : items)
+            include_in_bin(bins[sah_bin_index(item, axis, axisMin, axisLength)], item.bounds, 1);
+
+        std::array<Bin, SAH_BIN_COUNT> rightSums;
+        Bin sum;
+        for(size_t i = SAH_BIN_COUNT - 1; i > 0; i--) {
+            include_in_bin(sum, bins[i].bounds, bins[i].count);
+            rightSums[i] = sum;
+        }
+
+        sum = Bin();
+        for(size_t i = 0; i < SAH_BIN_COUNT - 1; i++) {
+            include_in_bin(sum, bins[i].bounds, bins[i].count);
+            const Bin& right = rightSums[i + 1];
+            if(sum.count == 0 || right.count == 0)
+                continue;
+            double cost = sah_view_overlap_cost(sum.bounds, sum.count) + sah_view_overlap_cost(right.bounds, right.count);
+            if(cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = i;
+            }
         }
     }
 
-    for(auto& p : parts) {
-        if(!p.empty())
-            build_bvh_node(bvhNode->children.emplace_back(std::make_shared<DrawingProgramCacheBVHNode>()), p);
+    if(!bestAxis.has_value()) // Every center is in the same spot, so any split is as good as another
+        return items.size() / 2;
+
+    int axis = bestAxis.value();
+    double axisMin = centerBounds.min[axis];
+    double axisLength = centerBounds.max[axis] - axisMin;
+    auto secondGroupBegin = std::partition(items.begin(), items.end(), [&](const SAHBuildItem& item) {
+        return sah_bin_index(item, axis, axisMin, axisLength) <= bestBin;
+    });
+    return secondGroupBegin - items.begin();
+}
+
+void DrawingProgramCache::split_components_sah(DrawingProgramCacheBVHNode& node, const std::vector<const BVHBuildComponent*>& components, size_t maxComponentsInSingleNode, std::vector<const BVHBuildComponent*>& componentsToKeep, std::vector<std::vector<const BVHBuildComponent*>>& parts) {
+    // Run the heuristic on doubles rather than WorldScalars. Bounds are made relative to the node, with the larger side of the node spanning [0, 1]
+    WorldVec nodeDim = node.bounds.dim();
+    WorldScalar normalizeScale = std::max(nodeDim.x(), nodeDim.y());
+    std::vector<SAHBuildItem> items;
+    items.reserve(components.size());
+    for(size_t i = 0; i < components.size(); i++) {
+        auto& item = items.emplace_back(i);
+        if(normalizeScale > WorldScalar(0)) {
+            const auto& cAABB = components[i]->bounds;
+            item.bounds.min = ((cAABB.min - node.bounds.min) / normalizeScale).cast<double>();
+            item.bounds.max = ((cAABB.max - node.bounds.min) / normalizeScale).cast<double>();
+        }
+        else
+            item.bounds = {Vector2d{0.0, 0.0}, Vector2d{0.0, 0.0}};
+    }
+
+    auto largeItemsEnd = std::partition(items.begin(), items.end(), [](const SAHBuildItem& item) {
+        return item.bounds.width() > SAH_LARGE_COMPONENT_FRACTION || item.bounds.height() > SAH_LARGE_COMPONENT_FRACTION;
+    });
+    size_t largeItemCount = largeItemsEnd - items.begin();
+    if(largeItemCount > maxComponentsInSingleNode) {
+        std::nth_element(items.begin(), items.begin() + maxComponentsInSingleNode, largeItemsEnd, [](const SAHBuildItem& a, const SAHBuildItem& b) {
+            return a.bounds.dim().maxCoeff() > b.bounds.dim().maxCoeff();
+        });
+        largeItemCount = maxComponentsInSingleNode;
+    }
+    for(size_t i = 0; i < largeItemCount; i++)
+        componentsToKeep.emplace_back(components[items[i].componentIndex]);
+
+    // Split twice so that nodes have up to four children, like the quadtree split
+    std::span<SAHBuildItem> remainingItems(items.begin() + largeItemCount, items.end());
+    std::vector<std::span<SAHBuildItem>> groups;
+    if(remainingItems.size() >= 2) {
+        size_t firstHalfSize = sah_partition(remainingItems);
+        for(std::span<SAHBuildItem> half : {remainingItems.first(firstHalfSize), remainingItems.subspan(firstHalfSize)}) {
+            if(half.size() >= 2) {
+                size_t firstQuarterSize = sah_partition(half);
+                groups.emplace_back(half.first(firstQuarterSize));
+                groups.emplace_back(half.subspan(firstQuarterSize));
+            }
+            else
+                groups.emplace_back(half);
+        }
+    }
+    else
+        groups.emplace_back(remainingItems);
+
+    for(auto& group : groups) {
+        auto& part = parts.emplace_back();
+        part.reserve(group.size());
+        for(auto& item : group)
+            part.emplace_back(components[item.componentIndex]);
+    }
+}
+
+std::vector<size_t> DrawingProgramCache::get_node_occupancy_histogram(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode) {
+    std::vector<size_t> histogram;
+    std::function<void(const std::shared_ptr<DrawingProgramCacheBVHNode>&)> add_node_to_histogram = [&](const std::shared_ptr<DrawingProgramCacheBVHNode>& node) {
+        size_t bucket = std::bit_width(node->components.size());
+        if(histogram.size() <= bucket)
+            histogram.resize(bucket + 1, 0);
+        histogram[bucket]++;
+        for(auto& child : node->children)
+            add_node_to_histogram(child);
+    };
+    if(bvhNode)
+        add_node_to_histogram(bvhNode);
+    return histogram;
+}
+
+void DrawingProgramCache::log_bvh_occupancy_comparison() const {
+    auto components = drawP.layerMan.get_flattened_component_list();
+    std::erase_if(components, [](auto& c) {
+        return !c->obj->get_world_bounds().has_value();
+    });
+
+    auto buildComponents = get_build_components(components);
+    std::vector<BVHComponentPlacement> placements;
+    BVHBuildSettings settings = get_build_settings();
+    settings.useSAH = false;
+    auto quadtreeRoot = std::make_shared<DrawingProgramCacheBVHNode>();
+    build_bvh_node(quadtreeRoot, get_build_component_pointers(buildComponents), settings, placements);
+    settings.useSAH = true;
+    auto sahRoot = std::make_shared<DrawingProgramCacheBVHNode>();
+    build_bvh_node(sahRoot, get_build_component_pointers(buildComponents), settings, placements);
+
+    auto quadtreeHistogram = get_node_occupancy_histogram(quadtreeRoot);
+    auto sahHistogram = get_node_occupancy_histogram(sahRoot);
+
+    std::string toLog = "[DrawingProgramCache::log_bvh_occupancy_comparison] Nodes by component count for " + std::to_string(components.size()) + " components (quadtree / SAH):";
+    for(size_t i = 0; i < std::max(quadtreeHistogram.size(), sahHistogram.size()); i++) {
+        std::string bucketName = i == 0 ? "0" : (std::to_string(size_t(1) << (i - 1)) + "-" + std::to_string((size_t(1) << i) - 1));
+        toLog += "\n    " + bucketName + ": " + std::to_string(i < quadtreeHistogram.size() ? quadtreeHistogram[i] : 0) + " / " + std::to_string(i < sahHistogram.size() ? sahHistogram[i] : 0);
+    }
+    Logger::get().log(Logger::LogType::INFO, toLog);
+}
+
+std::vector<DrawingProgramCache::BVHBuildComponent> DrawingProgramCache::get_build_components(const std::vector<CanvasComponentContainer::ObjInfo*>& components) {
+    std::vector<BVHBuildComponent> toRet;
+    toRet.reserve(components.size());
+    for(auto& c : components)
+        toRet.emplace_back(c, c->obj->get_world_bounds().value(), c->obj->coords, c->obj->parentLayer, c->pos);
+    return toRet;
+}
+
+std::vector<const DrawingProgramCache::BVHBuildComponent*> DrawingProgramCache::get_build_component_pointers(const std::vector<BVHBuildComponent>& buildComponents) {
+    std::vector<const BVHBuildComponent*> toRet;
+    toRet.reserve(buildComponents.size());
+    for(auto& c : buildComponents)
+        toRet.emplace_back(&c);
+    return toRet;
+}
+
+void DrawingProgramCache::add_components_to_node_in_draw_order(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, std::vector<const BVHBuildComponent*> components, std::vector<BVHComponentPlacement>& placements) {
+    // Runs on the worker thread while building, so the draw order from the snapshot is used
+    std::sort(components.begin(), components.end(), [](const BVHBuildComponent* a, const BVHBuildComponent* b) {
+        return a->layer != b->layer ? std::less<const DrawingProgramLayerListItem*>()(a->layer, b->layer) : a->pos < b->pos;
+    });
+    for(auto& c : components) {
+        bvhNode->components.emplace_back(c->comp);
+        placements.emplace_back(c->comp, bvhNode, ComponentDrawTransform::calculate_node_relative_coords(bvhNode->coords, c->coords));
     }
 }
 
-void DrawingProgramCache::build_bvh_node_coords_and_resolution(DrawingProgramCacheBVHNode& node) {
+void DrawingProgramCache::apply_component_placements(const std::vector<BVHComponentPlacement>& placements) {
+    for(auto& placement : placements) {
+        placement.comp->obj->cacheParentBvhNode = placement.node;
+        placement.comp->obj->cacheParentBvhNodeRelativeCoords = placement.relativeCoords;
+    }
+}
+
+void DrawingProgramCache::set_component_parent_node(CanvasComponentContainer::ObjInfo* c, const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode) {
+    c->obj->cacheParentBvhNode = bvhNode;
+    c->obj->cacheParentBvhNodeRelativeCoords = ComponentDrawTransform::calculate_node_relative_coords(bvhNode->coords, c->obj->coords);
+}
+
+void DrawingProgramCache::build_bvh_node_coords_and_resolution(DrawingProgramCacheBVHNode& node, size_t nodeResolution) {
     // These are part of the draw cache data, but we're putting it out here, because:
     //  - We dont have to recalculate it every time we refresh the cache
     //  - Some of the data here is needed to determine whether to generate the cache in the first place
 
     WorldVec cacheBoundDim = node.bounds.dim();
     if(cacheBoundDim.x() > cacheBoundDim.y()) {
-        node.resolution.x() = CACHE_NODE_RESOLUTION;
-        node.resolution.y() = CACHE_NODE_RESOLUTION * static_cast<double>(cacheBoundDim.y() / cacheBoundDim.x());
+        node.resolution.x() = nodeResolution;
+        node.resolution.y() = nodeResolution * static_cast<double>(cacheBoundDim.y() / cacheBoundDim.x());
     }
     else {
-        node.resolution.y() = CACHE_NODE_RESOLUTION;
-        node.resolution.x() = CACHE_NODE_RESOLUTION * static_cast<double>(cacheBoundDim.x() / cacheBoundDim.y());
+        node.resolution.y() = nodeResolution;
+        node.resolution.x() = nodeResolution * static_cast<double>(cacheBoundDim.x() / cacheBoundDim.y());
     }
     node.coords.rotation = 0.0;
     node.coords.pos = node.bounds.min;
@@ -255,31 +854,52 @@ void DrawingProgramCache::build_bvh_node_coords_and_resolution(DrawingProgramCac
 }
 
 void DrawingProgramCache::refresh_all_draw_cache(const DrawData& drawData) {
+    std::vector<std::shared_ptr<DrawingProgramCacheBVHNode>> nodesToRefresh;
     traverse_bvh_run_function(drawData.cam.viewingAreaGenerousCollider, [&](std::shared_ptr<DrawingProgramCacheBVHNode> node) {
         if(node && node->coords.inverseScale <= drawData.cam.c.inverseScale) {
-            refresh_draw_cache(node, drawData);
+            nodesToRefresh.emplace_back(node);
             return false;
         }
         return true;
     });
-}
-
-void DrawingProgramCache::traverse_bvh_run_function(const SCollision::AABB<WorldScalar>& aabb, std::function<bool(const std::shared_ptr<DrawingProgramCacheBVHNode>& node)> f) {
-    f(nullptr);
-    traverse_bvh_run_function_starting_at_node(bvhRoot, aabb, f);
-}
 
-void DrawingProgramCache::traverse_bvh_run_function_starting_at_node(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, const SCollision::AABB<WorldScalar>& aabb, std::function<bool(const std::shared_ptr<DrawingProgramCacheBVHNode>& node)> f) {
-    if(bvhNode && SCollision::collide(aabb, bvhNode->bounds) && f(bvhNode)) {
-        for(auto& p : bvhNode->children)
-            traverse_bvh_run_function_starting_at_node(p, aabb, f);
-    }
-}
+    // Nodes closest to the center of the view are rendered first. Nodes left stale when the budget runs out are drawn from their
+    // components until they're rendered in a later frame
+    Vector2f viewCenter = drawData.cam.viewingArea * 0.5f;
+    std::vector<WorldVec> nodeCenters(nodesToRefresh.size());
+    for(size_t i = 0; i < nodesToRefresh.size(); i++)
+        nodeCenters[i] = nodesToRefresh[i]->bounds.center();
+    std::vector<Vector2f> nodeCentersOnScreen = drawData.cam.c.to_space(nodeCenters);
+    std::vector<std::pair<float, std::shared_ptr<DrawingProgramCacheBVHNode>>> nodesByDistance;
+    nodesByDistance.reserve(nodesToRefresh.size());
+    for(size_t i = 0; i < nodesToRefresh.size(); i++)
+        nodesByDistance.emplace_back((nodeCentersOnScreen[i] - viewCenter).squaredNorm(), nodesToRefresh[i]);
+    std::sort(nodesByDistance.begin(), nodesByDistance.end(), [](auto& a, auto& b) {
+        return a.first < b.first;
+    });
 
-void DrawingProgramCache::traverse_bvh_run_function_starting_at_node_no_collision_check(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, std::function<bool(const std::shared_ptr<DrawingProgramCacheBVHNode>& node)> f) {
-    if(bvhNode && f(bvhNode)) {
-        for(auto& p : bvhNode->children)
-            traverse_bvh_run_function_starting_at_node_no_collision_check(p, f);
+    auto refreshStart = std::chrono::steady_clock::now();
+    bool renderedNode = false;
+    // Nodes deferred by the last call were drawn into the window cache approximately, so it's redrawn where they're rendered now
+    bool windowCacheHasDeferredNodes = nodeRefreshPending && windowCache.attachedDrawingProgramCache == this;
+    nodeRefreshPending = false;
+    for(auto& [distance, node] : nodesByDistance) {
+        auto it = nodeCacheMap.find(node);
+        bool isStale = (it == nodeCacheMap.end() || it->second.invalidBounds.has_value()) && !(node->children.empty() && node->components.empty());
+        if(isStale) {
+            if(renderedNode && std::chrono::steady_clock::now() - refreshStart >= std::chrono::milliseconds(CACHE_REFRESH_BUDGET_MILLISECONDS)) {
+                nodeRefreshPending = true;
+                continue;
+            }
+            renderedNode = true;
+            if(windowCacheHasDeferredNodes) {
+                if(windowCache.invalidBounds.has_value())
+                    windowCache.invalidBounds.value().include_aabb_in_bounds(node->bounds);
+                else
+                    windowCache.invalidBounds = node->bounds;
+            }
+        }
+        refresh_draw_cache(node, drawData);
     }
 }
 
@@ -290,13 +910,22 @@ void DrawingProgramCache::refresh_draw_cache(const std::shared_ptr<DrawingProgra
     NodeCache nodeCache;
     auto bvhNodeCacheIt = nodeCacheMap.find(bvhNode);
     if(bvhNodeCacheIt != nodeCacheMap.end()) {
-        nodeCache = bvhNodeCacheIt->second;
-        if(!nodeCache.invalidBounds.has_value()) // Node is cached already, and doesn't have invalid areas, so there's nothing to do
+        nodeCacheStats.hits++;
+        if(!bvhNodeCacheIt->second.invalidBounds.has_value()) { // Node is cached already, and doesn't have invalid areas, so there's nothing to do
+            node_cache_lru_touch(*bvhNodeCacheIt);
             return;
-        nodeCacheMap.erase(bvhNode); // Ensure nodeCache is erased, so that the draw_components_to_canvas function doesnt use it while drawing
+        }
+        nodeCache = bvhNodeCacheIt->second;
+        erase_node_cache(bvhNode); // Ensure nodeCache is erased, so that the draw_components_to_canvas function doesnt use it while drawing
     }
-    else
+    else {
+        nodeCacheStats.misses++;
+        nodeCache.surfaceBytes = static_cast<size_t>(bvhNode->resolution.x()) * static_cast<size_t>(bvhNode->resolution.y()) * 4; // 4 bytes per pixel (RGBA)
+        evict_node_caches_to_fit(nodeCache.surfaceBytes); // Evict before allocating, so that memory use never goes over the budget
         nodeCache.surface = drawP.world.main.create_native_surface(bvhNode->resolution, true);
+    }
+
+    RenderStats::current().bvhNodesRerendered++;
 
     SkCanvas* cacheCanvas = nodeCache.surface->getCanvas();
 
@@ -338,19 +967,87 @@ void DrawingProgramCache::refresh_draw_cache(const std::shared_ptr<DrawingProgra
         draw_components_to_canvas(cacheCanvas, cacheDrawData, std::nullopt);
     }
 
-    nodeCache.lastRenderTime = std::chrono::steady_clock::now();
     nodeCache.attachedDrawingProgramCache = this;
 
-    while(nodeCacheMap.size() >= MAXIMUM_DRAW_CACHE_SURFACES) {
-        auto leastUsedNodeIt = nodeCacheMap.begin();
-        for(auto it = nodeCacheMap.begin(); it != nodeCacheMap.end(); ++it) {
-            if(it->second.lastRenderTime < leastUsedNodeIt->second.lastRenderTime)
-                leastUsedNodeIt = it;
-        }
-        nodeCacheMap.erase(leastUsedNodeIt);
+    emplace_node_cache(bvhNode, nodeCache); // Set the nodeCache after rendering is done, so that the draw function doesnt assume we have this node cached
+}
+
+void DrawingProgramCache::emplace_node_cache(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, const NodeCache& nodeCache) {
+    auto [it, inserted] = nodeCacheMap.emplace(bvhNode, nodeCache);
+    if(inserted) {
+        it->second.lruPrev = nullptr;
+        it->second.lruNext = nullptr;
+        node_cache_lru_link_front(*it);
+        nodeCacheStats.bytesResident += it->second.surfaceBytes;
+        add_to_cached_node_counts(bvhNode, 1);
+    }
+}
+
+void DrawingProgramCache::erase_node_cache(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode) {
+    auto it = nodeCacheMap.find(bvhNode);
+    if(it != nodeCacheMap.end()) {
+        node_cache_lru_unlink(*it);
+        nodeCacheStats.bytesResident -= it->second.surfaceBytes;
+        nodeCacheMap.erase(it);
+        add_to_cached_node_counts(bvhNode, -1);
+    }
+}
+
+void DrawingProgramCache::add_to_cached_node_counts(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, int64_t amount) {
+    for(std::shared_ptr<DrawingProgramCacheBVHNode> node = bvhNode; node; node = node->parent.lock())
+        node->cachedNodeCount += amount;
+}
+
+void DrawingProgramCache::node_cache_lru_link_front(NodeCacheMapEntry& entry) {
+    entry.second.lruPrev = nullptr;
+    entry.second.lruNext = nodeCacheLRUFront;
+    if(nodeCacheLRUFront)
+        nodeCacheLRUFront->second.lruPrev = &entry;
+    else
+        nodeCacheLRUBack = &entry;
+    nodeCacheLRUFront = &entry;
+}
+
+void DrawingProgramCache::node_cache_lru_unlink(NodeCacheMapEntry& entry) {
+    if(entry.second.lruPrev)
+        entry.second.lruPrev->second.lruNext = entry.second.lruNext;
+    else
+        nodeCacheLRUFront = entry.second.lruNext;
+    if(entry.second.lruNext)
+        entry.second.lruNext->second.lruPrev = entry.second.lruPrev;
+    else
+        nodeCacheLRUBack = entry.second.lruPrev;
+    entry.second.lruPrev = nullptr;
+    entry.second.lruNext = nullptr;
+}
+
+void DrawingProgramCache::node_cache_lru_touch(NodeCacheMapEntry& entry) {
+    if(nodeCacheLRUFront != &entry) {
+        node_cache_lru_unlink(entry);
+        node_cache_lru_link_front(entry);
     }
+}
 
-    nodeCacheMap.emplace(bvhNode, nodeCache); // Set the nodeCache after rendering is done, so that the draw function doesnt assume we have this node cached
+void DrawingProgramCache::evict_node_caches_to_fit(size_t bytesToFit) {
+    size_t budgetBytes = DRAW_CACHE_MEMORY_BUDGET_MB * 1024 * 1024;
+    size_t layerCacheBytes = get_layer_cache_bytes_resident();
+    while(nodeCacheLRUBack && nodeCacheStats.bytesResident + layerCacheBytes + bytesToFit > budgetBytes) {
+        std::shared_ptr<DrawingProgramCacheBVHNode> leastUsedNode = nodeCacheLRUBack->first;
+        erase_node_cache(leastUsedNode);
+        nodeCacheStats.evictions++;
+    }
+}
+
+size_t DrawingProgramCache::get_layer_cache_bytes_resident() {
+    size_t toRet = 0;
+    for(auto& [layer, layerCache] : windowCache.layerCaches)
+        toRet += layerCache.surfaceBytes;
+    return toRet;
+}
+
+const DrawingProgramCache::NodeCacheStats& DrawingProgramCache::get_node_cache_stats() {
+    nodeCacheStats.layerCacheBytesResident = get_layer_cache_bytes_resident();
+    return nodeCacheStats;
 }
 
 void DrawingProgramCache::allocate_window_cache_area() {
@@ -358,39 +1055,232 @@ void DrawingProgramCache::allocate_window_cache_area() {
     windowCache.surface = drawP.world.main.create_native_surface(windowSize, true);
 }
 
-void DrawingProgramCache::update_window_cache_invalid_bounds(const DrawData& drawData) {
-    auto invalidBound = windowCache.invalidBounds.value();
-    if(SCollision::collide(invalidBound, drawData.cam.viewingAreaGenerousCollider)) {
-        auto iBounds = drawData.cam.viewingAreaGenerousCollider.get_intersection_between_aabbs(invalidBound);
+std::optional<SkIRect> DrawingProgramCache::get_window_area_to_refresh(const DrawData& windowDrawData, const SCollision::AABB<WorldScalar>& invalidBounds) {
+    if(!SCollision::collide(invalidBounds, windowDrawData.cam.viewingAreaGenerousCollider))
+        return std::nullopt;
+    auto iBounds = windowDrawData.cam.viewingAreaGenerousCollider.get_intersection_between_aabbs(invalidBounds);
 
-        SCollision::AABB<float> cameraSpaceInvalidAABB = drawData.cam.c.world_collider_to_coords<SCollision::AABB<float>>(iBounds);
-        SCollision::AABB<float> clipRectBoundAABB{cameraSpaceInvalidAABB.min - Vector2f{4, 4}, cameraSpaceInvalidAABB.max + Vector2f{4, 4}};
+    SCollision::AABB<float> cameraSpaceInvalidAABB = windowDrawData.cam.c.world_collider_to_coords<SCollision::AABB<float>>(iBounds);
+    SCollision::AABB<float> clipRectBoundAABB{cameraSpaceInvalidAABB.min - Vector2f{4, 4}, cameraSpaceInvalidAABB.max + Vector2f{4, 4}};
 
-        SkIRect clipRect = SkIRect::MakeLTRB(clipRectBoundAABB.min.x(),
-                                             clipRectBoundAABB.min.y(),
-                                             clipRectBoundAABB.max.x(),
-                                             clipRectBoundAABB.max.y());
+    return SkIRect::MakeLTRB(clipRectBoundAABB.min.x(),
+                             clipRectBoundAABB.min.y(),
+                             clipRectBoundAABB.max.x(),
+                             clipRectBoundAABB.max.y());
+}
 
-        SCollision::AABB<WorldScalar> clipRectBoundAABBWorld = drawData.cam.c.collider_to_world<SCollision::AABB<WorldScalar>>(clipRectBoundAABB);
+void DrawingProgramCache::update_window_cache_invalid_bounds(const DrawData& windowDrawData) {
+    std::optional<SkIRect> area = get_window_area_to_refresh(windowDrawData, windowCache.invalidBounds.value());
+    if(area.has_value())
+        window_cache_refresh_area(windowDrawData, area.value());
+    windowCache.invalidBounds = std::nullopt;
+}
 
-        SkCanvas* cacheCanvas = windowCache.surface->getCanvas();
-        cacheCanvas->save();
-        cacheCanvas->clipIRect(clipRect);
-        cacheCanvas->clear(SkColor4f{0, 0, 0, 0});
-        draw_components_to_canvas(cacheCanvas, drawData, clipRectBoundAABBWorld);
-        cacheCanvas->restore();
+void DrawingProgramCache::window_cache_refresh_area(const DrawData& windowDrawData, const SkIRect& area) {
+    SCollision::AABB<float> areaAABB{Vector2f{area.left(), area.top()}, Vector2f{area.right(), area.bottom()}};
+    SCollision::AABB<WorldScalar> areaWorld = windowDrawData.cam.c.collider_to_world<SCollision::AABB<WorldScalar>>(areaAABB);
+
+    SkCanvas* cacheCanvas = windowCache.surface->getCanvas();
+    cacheCanvas->save();
+    cacheCanvas->clipIRect(area);
+    cacheCanvas->clear(SkColor4f{0, 0, 0, 0});
+    draw_components_to_canvas(cacheCanvas, windowDrawData, areaWorld, windowCache.layerCachesValid, true);
+    cacheCanvas->restore();
+}
+
+// Visible layers that aren't being edited, and have enough components to be worth flattening
+static void get_layers_to_cache(const DrawingProgramLayerListItem& layerListItem, const DrawingProgramLayerListItem* editingLayer, std::vector<const DrawingProgramLayerListItem*>& layersToCache) {
+    if(!layerListItem.get_visible())
+        return;
+    if(layerListItem.is_folder()) {
+        for(auto& p : *layerListItem.get_folder().folderList)
+            get_layers_to_cache(*p.obj, editingLayer, layersToCache);
     }
-    windowCache.invalidBounds = std::nullopt;
+    else if(&layerListItem != editingLayer && layerListItem.get_component_count() >= LAYER_CACHE_MINIMUM_COMPONENT_COUNT)
+        layersToCache.emplace_back(&layerListItem);
+}
+
+bool DrawingProgramCache::update_layer_caches(const DrawData& drawData) {
+    const DrawingProgramLayerListItem* editingLayer = drawP.layerMan.get_layer_being_edited();
+    if(MAXIMUM_CACHED_LAYERS == 0 || !editingLayer) {
+        windowCache.layerCaches.clear();
+        windowCache.layerCachesValid = false;
+        return false;
+    }
+
+    if(windowCache.layerCachesValid && windowCache.layerCachesEditingLayer == editingLayer) {
+        for(auto& [layer, layerCache] : windowCache.layerCaches) {
+            if(layerCache.invalidBounds.has_value()) {
+                std::optional<SkIRect> area = get_window_area_to_refresh(drawData, layerCache.invalidBounds.value());
+                if(area.has_value())
+                    layer_cache_refresh_area(*layer, layerCache, drawData, area);
+                layerCache.invalidBounds = std::nullopt;
+            }
+        }
+        return !windowCache.layerCaches.empty();
+    }
+
+    // Every cached layer is drawn across the whole window, so wait until the camera stops moving
+    if(drawData.cam.c != windowCache.lastFrameCamCoords)
+        return false;
+
+    // Drawing a layer across the whole window can take longer than a frame's refresh budget, so layers are drawn over several frames.
+    // The layer caches are only used once all of them are drawn
+
+    std::vector<const DrawingProgramLayerListItem*> layersToCache;
+    get_layers_to_cache(drawP.layerMan.get_layer_root(), editingLayer, layersToCache);
+    std::stable_sort(layersToCache.begin(), layersToCache.end(), [](auto& a, auto& b) {
+        return a->get_component_count() > b->get_component_count();
+    });
+    // Layer caches count towards the same memory budget as the node surfaces, which are evicted to make room for them
+    const Vector2i& windowSize = drawP.world.main.window.size;
+    size_t layerCacheBytes = static_cast<size_t>(windowSize.x()) * static_cast<size_t>(windowSize.y()) * 4; // 4 bytes per pixel (RGBA)
+    size_t maximumCachedLayers = layerCacheBytes == 0 ? 0 : std::min(MAXIMUM_CACHED_LAYERS, (DRAW_CACHE_MEMORY_BUDGET_MB * 1024 * 1024) / layerCacheBytes);
+    if(layersToCache.size() > maximumCachedLayers)
+        layersToCache.resize(maximumCachedLayers);
+
+    std::erase_if(windowCache.layerCaches, [&](auto& layerCachePair) {
+        return std::find(layersToCache.begin(), layersToCache.end(), layerCachePair.first) == layersToCache.end();
+    });
+    auto refreshStart = std::chrono::steady_clock::now();
+    bool drewLayer = false;
+    bool allLayersDrawn = true;
+    for(const DrawingProgramLayerListItem* layer : layersToCache) {
+        LayerCache& layerCache = windowCache.layerCaches[layer];
+        if(layerCache.drawn) {
+            if(layerCache.invalidBounds.has_value()) {
+                std::optional<SkIRect> area = get_window_area_to_refresh(drawData, layerCache.invalidBounds.value());
+                if(area.has_value())
+                    layer_cache_refresh_area(*layer, layerCache, drawData, area);
+                layerCache.invalidBounds = std::nullopt;
+            }
+            continue;
+        }
+        if(drewLayer && std::chrono::steady_clock::now() - refreshStart >= std::chrono::milliseconds(CACHE_REFRESH_BUDGET_MILLISECONDS)) {
+            allLayersDrawn = false;
+            continue;
+        }
+        if(layerCache.surface == nullptr) {
+            evict_node_caches_to_fit(layerCacheBytes);
+            layerCache.surface = drawP.world.main.create_native_surface(windowSize, true);
+            layerCache.surfaceBytes = layerCacheBytes;
+        }
+        layer_cache_refresh_area(*layer, layerCache, drawData, std::nullopt);
+        layerCache.invalidBounds = std::nullopt;
+        layerCache.drawn = true;
+        drewLayer = true;
+    }
+    if(!allLayersDrawn)
+        return false;
+    windowCache.layerCachesValid = true;
+    windowCache.layerCachesEditingLayer = editingLayer;
+    return !windowCache.layerCaches.empty();
+}
+
+void DrawingProgramCache::invalidate_layer_caches() {
+    // Invalidation is only tracked for the area in view, so the layer caches have to be drawn again whenever the window cache's camera changes
+    windowCache.layerCachesValid = false;
+    for(auto& [layer, layerCache] : windowCache.layerCaches)
+        layerCache.drawn = false;
+}
+
+void DrawingProgramCache::layer_cache_refresh_area(const DrawingProgramLayerListItem& layerListItem, LayerCache& layerCache, const DrawData& drawData, const std::optional<SkIRect>& area) {
+    // Node surfaces have every layer flattened into them, so all nodes in view are drawn from their components
+    std::vector<std::shared_ptr<DrawingProgramCacheBVHNode>> nodesToDraw;
+    traverse_bvh_run_function_starting_at_node(bvhRoot, drawData.cam.viewingAreaGenerousCollider, [&](const std::shared_ptr<DrawingProgramCacheBVHNode>& node) {
+        if(node->coords.inverseScale > (drawData.cam.c.inverseScale >> CanvasComponentContainer::COMP_MIN_SHIFT_BEFORE_DISAPPEAR)) {
+            nodesToDraw.emplace_back(node);
+            return true;
+        }
+        return false;
+    });
+    for(auto& node : nodesToDraw) {
+        node->camRelativeOrigin = ComponentDrawTransform::calculate_camera_relative_node_origin(drawData.cam.c, node->coords);
+        node->drawReducedQuality = false;
+    }
+
+    std::optional<SCollision::AABB<WorldScalar>> drawBounds;
+    SkCanvas* cacheCanvas = layerCache.surface->getCanvas();
+    cacheCanvas->save();
+    if(area.has_value()) {
+        SCollision::AABB<float> areaAABB{Vector2f{area.value().left(), area.value().top()}, Vector2f{area.value().right(), area.value().bottom()}};
+        drawBounds = drawData.cam.c.collider_to_world<SCollision::AABB<WorldScalar>>(areaAABB);
+        cacheCanvas->clipIRect(area.value());
+    }
+    cacheCanvas->clear(SkColor4f{0, 0, 0, 0});
+    // The layer's alpha and blend mode are applied when the cache is drawn, same as when it's drawn from its components
+    draw_layer_components_to_canvas(layerListItem, cacheCanvas, drawData, drawBounds, nodesToDraw);
+    cacheCanvas->restore();
 }
 
 void DrawingProgramCache::window_cache_complete_refresh(const DrawData& drawData) {
+    if(windowCache.attachedDrawingProgramCache != this)
+        windowCache.layerCaches.clear(); // Layer caches of another canvas
+    invalidate_layer_caches();
     SkCanvas* cacheCanvas = windowCache.surface->getCanvas();
     cacheCanvas->save();
     cacheCanvas->clear(SkColor4f{0, 0, 0, 0});
-    draw_components_to_canvas(cacheCanvas, drawData, std::nullopt);
+    draw_components_to_canvas(cacheCanvas, drawData, std::nullopt, false, true);
     cacheCanvas->restore();
     windowCache.attachedDrawingProgramCache = this;
     windowCache.coords = drawData.cam.c;
+    windowCache.invalidBounds = std::nullopt;
+}
+
+bool DrawingProgramCache::window_cache_reproject_pan(const DrawData& drawData) {
+    // Only the camera position changed. The surface is shifted by whole pixels, and only the strips exposed by the shift are drawn.
+    // The leftover subpixel offset is applied when the surface is drawn to the screen
+    Vector2f offset = windowCache.coords.to_space(drawData.cam.c.pos);
+    Vector2i shift{static_cast<int>(std::round(offset.x())), static_cast<int>(std::round(offset.y()))};
+    const Vector2i& windowSize = drawP.world.main.window.size;
+    if(std::abs(shift.x()) >= windowSize.x() || std::abs(shift.y()) >= windowSize.y())
+        return false;
+    if(shift == Vector2i{0, 0})
+        return true;
+
+    refresh_all_draw_cache(drawData);
+    if(windowCache.scratchSurface == nullptr)
+        windowCache.scratchSurface = drawP.world.main.create_native_surface(windowSize, true);
+    SkPaint srcPaint;
+    srcPaint.setBlendMode(SkBlendMode::kSrc);
+    windowCache.scratchSurface->getCanvas()->drawImage(windowCache.surface->makeTemporaryImage(), -shift.x(), -shift.y(), {SkFilterMode::kNearest, SkMipmapMode::kNone}, &srcPaint);
+    std::swap(windowCache.surface, windowCache.scratchSurface);
+    windowCache.coords.pos = windowCache.coords.from_space(shift.cast<float>());
+    invalidate_layer_caches();
+
+    DrawData windowDrawData = get_window_cache_draw_data(drawData);
+    if(shift.x() > 0)
+        window_cache_refresh_area(windowDrawData, SkIRect::MakeLTRB(windowSize.x() - shift.x(), 0, windowSize.x(), windowSize.y()));
+    else if(shift.x() < 0)
+        window_cache_refresh_area(windowDrawData, SkIRect::MakeLTRB(0, 0, -shift.x(), windowSize.y()));
+    if(shift.y() > 0)
+        window_cache_refresh_area(windowDrawData, SkIRect::MakeLTRB(0, windowSize.y() - shift.y(), windowSize.x(), windowSize.y()));
+    else if(shift.y() < 0)
+        window_cache_refresh_area(windowDrawData, SkIRect::MakeLTRB(0, 0, windowSize.x(), -shift.y()));
+    return true;
+}
+
+bool DrawingProgramCache::window_cache_can_preview_zoom(const DrawData& drawData) const {
+    // Only preview while the camera is moving, so that the exact redraw happens once the zoom stops. Only zooming in is previewed,
+    // since zooming out shows area outside the window cache, which would have to be drawn every frame
+    if(windowCache.invalidBounds.has_value() || drawData.cam.c == windowCache.lastFrameCamCoords || drawData.cam.c.rotation != windowCache.coords.rotation)
+        return false;
+    double magnification = static_cast<double>(windowCache.coords.inverseScale / drawData.cam.c.inverseScale);
+    if(magnification > WINDOW_CACHE_MAXIMUM_ZOOM_PREVIEW_MAGNIFICATION)
+        return false;
+    // The view must be inside the area the window cache was drawn for, otherwise parts of the screen would be left empty
+    Vector2f viewMin = windowCache.coords.to_space(drawData.cam.c.pos);
+    Vector2f viewMax = windowCache.coords.to_space(drawData.cam.c.from_space(drawData.cam.viewingArea));
+    Vector2f windowSize = drawP.world.main.window.size.cast<float>();
+    return viewMin.x() >= -1.0f && viewMin.y() >= -1.0f && viewMax.x() <= windowSize.x() + 1.0f && viewMax.y() <= windowSize.y() + 1.0f;
+}
+
+DrawData DrawingProgramCache::get_window_cache_draw_data(const DrawData& drawData) const {
+    DrawData windowDrawData = drawData;
+    windowDrawData.cam.c = windowCache.coords;
+    windowDrawData.cam.set_viewing_area(drawData.cam.viewingArea);
+    windowDrawData.refresh_draw_optimizing_values();
+    return windowDrawData;
 }
 
 void DrawingProgramCache::update_and_draw_cached_canvas(SkCanvas* canvas, const DrawData& drawData) {
@@ -399,91 +1289,194 @@ void DrawingProgramCache::update_and_draw_cached_canvas(SkCanvas* canvas, const
         refresh_all_draw_cache(drawData);
         window_cache_complete_refresh(drawData);
     }
-    else if(windowCache.attachedDrawingProgramCache != this || drawData.cam.c != windowCache.coords) {
+    else if(windowCache.attachedDrawingProgramCache != this) {
         refresh_all_draw_cache(drawData);
         window_cache_complete_refresh(drawData);
     }
+    else if(drawData.cam.c != windowCache.coords) {
+        if(drawData.cam.c.inverseScale == windowCache.coords.inverseScale && drawData.cam.c.rotation == windowCache.coords.rotation) {
+            // Pans move by fractions of a pixel, while the window cache only moves by whole pixels. Once the camera stops, the cache is
+            // redrawn at the exact camera position, so that idle frames don't keep reprojecting the leftover offset
+            if(drawData.cam.c == windowCache.lastFrameCamCoords || !window_cache_reproject_pan(drawData)) {
+                refresh_all_draw_cache(drawData);
+                window_cache_complete_refresh(drawData);
+            }
+            else if(windowCache.invalidBounds.has_value())
+                update_window_cache_invalid_bounds(get_window_cache_draw_data(drawData));
+        }
+        else if(!window_cache_can_preview_zoom(drawData)) {
+            refresh_all_draw_cache(drawData);
+            window_cache_complete_refresh(drawData);
+        }
+    }
     else if(windowCache.invalidBounds.has_value()) {
-        refresh_all_draw_cache(drawData);
+        // While the camera is still, the layers that aren't being edited are drawn from their layer caches instead of the nodes,
+        // so stale nodes are left until the camera moves again
+        if(!update_layer_caches(drawData))
+            refresh_all_draw_cache(drawData);
         update_window_cache_invalid_bounds(drawData);
     }
-    canvas->drawImage(windowCache.surface->makeTemporaryImage(), 0, 0, {SkFilterMode::kNearest, SkMipmapMode::kNone}, nullptr);
+    else if(nodeRefreshPending) {
+        // Stale nodes were drawn into the window cache from their old surfaces or at reduced quality, so the window cache is
+        // redrawn over each one as it's rendered
+        refresh_all_draw_cache(drawData);
+        if(windowCache.invalidBounds.has_value())
+            update_window_cache_invalid_bounds(drawData);
+    }
+    windowCache.lastFrameCamCoords = drawData.cam.c;
+
+    if(windowCache.coords == drawData.cam.c)
+        canvas->drawImage(windowCache.surface->makeTemporaryImage(), 0, 0, {SkFilterMode::kNearest, SkMipmapMode::kNone}, nullptr);
+    else {
+        // Surface was drawn with a slightly different camera (subpixel pan offset, or zoom preview)
+        SkFilterMode filterMode = windowCache.coords.inverseScale == drawData.cam.c.inverseScale ? SkFilterMode::kNearest : SkFilterMode::kLinear;
+        canvas->save();
+        windowCache.coords.transform_sk_canvas(canvas, drawData);
+        canvas->drawImage(windowCache.surface->makeTemporaryImage(), 0, 0, {filterMode, SkMipmapMode::kNone}, nullptr);
+        canvas->restore();
+    }
 }
 
-void DrawingProgramCache::draw_components_to_canvas(SkCanvas* canvas, const DrawData& drawData, const std::optional<SCollision::AABB<WorldScalar>>& drawBounds) {
+void DrawingProgramCache::draw_components_to_canvas(SkCanvas* canvas, const DrawData& drawData, const std::optional<SCollision::AABB<WorldScalar>>& drawBounds, bool useLayerCaches, bool approximateDeferredNodes) {
     if(drawP.layerMan.layer_tree_root_exists()) {
         std::vector<std::shared_ptr<DrawingProgramCacheBVHNode>> cachedNodesToDraw;
         std::vector<std::shared_ptr<DrawingProgramCacheBVHNode>> uncachedNodes;
 
         traverse_bvh_run_function(drawData.cam.viewingAreaGenerousCollider, [&](const std::shared_ptr<DrawingProgramCacheBVHNode>& node) {
-            if(node) {
+            RenderStats::current().bvhNodesVisited++;
+            // Node surfaces have every layer flattened into them, so they can't be drawn alongside the layer caches. The layers that
+            // aren't cached are drawn from their components instead
+            bool isDeferred = false;
+            if(node && !useLayerCaches) {
+                isDeferred = approximateDeferredNodes && nodeRefreshPending && node->coords.inverseScale <= drawData.cam.c.inverseScale;
                 auto it = nodeCacheMap.find(node);
                 if(it != nodeCacheMap.end()) {
                     auto& nodeCache = it->second;
-                    if(!nodeCache.invalidBounds.has_value() && node->coords.inverseScale <= drawData.cam.c.inverseScale) {
+                    // A stale node the refresh budget deferred keeps showing its old surface until it's rendered again
+                    if((!nodeCache.invalidBounds.has_value() || isDeferred) && node->coords.inverseScale <= drawData.cam.c.inverseScale) {
                         cachedNodesToDraw.emplace_back(node);
                         return false;
                     }
                 }
             }
-            if(node && node->coords.inverseScale > (drawData.cam.c.inverseScale >> CanvasComponentContainer::COMP_MIN_SHIFT_BEFORE_DISAPPEAR)) // Not the "unsorted components" node (which is nullptr)
+            if(node && node->coords.inverseScale > (drawData.cam.c.inverseScale >> CanvasComponentContainer::COMP_MIN_SHIFT_BEFORE_DISAPPEAR)) { // Not the "unsorted components" node (which is nullptr)
+                node->drawReducedQuality = isDeferred;
                 uncachedNodes.emplace_back(node);
+            }
             else
                 return false;
             return true;
         });
 
-        recursive_draw_layer_item_to_canvas(drawP.layerMan.get_layer_root(), canvas, drawData, drawBounds, uncachedNodes);
+        for(auto& node : uncachedNodes)
+            node->camRelativeOrigin = ComponentDrawTransform::calculate_camera_relative_node_origin(drawData.cam.c, node->coords);
+
+        recursive_draw_layer_item_to_canvas(drawP.layerMan.get_layer_root(), canvas, drawData, drawBounds, uncachedNodes, useLayerCaches);
 
         for(auto& nodeCacheToDraw : cachedNodesToDraw)
             draw_cache_image_to_canvas(canvas, drawData, nodeCacheToDraw);
+        RenderStats::current().bvhNodesDrawnFromCache += cachedNodesToDraw.size();
     }
 }
 
-void DrawingProgramCache::recursive_draw_layer_item_to_canvas(const DrawingProgramLayerListItem& layerListItem, SkCanvas* canvas, const DrawData& drawData, const std::optional<SCollision::AABB<WorldScalar>>& drawBounds, const std::vector<std::shared_ptr<DrawingProgramCacheBVHNode>>& nodesToDraw) {
+void DrawingProgramCache::recursive_draw_layer_item_to_canvas(const DrawingProgramLayerListItem& layerListItem, SkCanvas* canvas, const DrawData& drawData, const std::optional<SCollision::AABB<WorldScalar>>& drawBounds, const std::vector<std::shared_ptr<DrawingProgramCacheBVHNode>>& nodesToDraw, bool useLayerCaches) {
     if(layerListItem.get_visible()) {
-        SkPaint layerPaint;
-        layerPaint.setAlphaf(layerListItem.get_alpha());
-        layerPaint.setBlendMode(serialized_blend_mode_to_sk_blend_mode(layerListItem.get_blend_mode()));
-        canvas->saveLayer(nullptr, &layerPaint);
+        // Most layers are fully opaque with the default blend mode, and don't need an offscreen layer to be composited from
+        bool drawInOffscreenLayer = layerListItem.needs_offscreen_layer();
+        if(drawInOffscreenLayer) {
+            SkPaint layerPaint;
+            layerPaint.setAlphaf(layerListItem.get_alpha());
+            layerPaint.setBlendMode(serialized_blend_mode_to_sk_blend_mode(layerListItem.get_blend_mode()));
+            canvas->saveLayer(nullptr, &layerPaint);
+            RenderStats::current().saveLayerCount++;
+        }
         if(layerListItem.is_folder()) {
             for(auto& p : *layerListItem.get_folder().folderList | std::views::reverse)
-                recursive_draw_layer_item_to_canvas(*p.obj, canvas, drawData, drawBounds, nodesToDraw);
+                recursive_draw_layer_item_to_canvas(*p.obj, canvas, drawData, drawBounds, nodesToDraw, useLayerCaches);
         }
         else {
-            std::vector<CanvasComponentContainer::ObjInfo*> compsToDraw;
-            parallel_loop_container(nodesToDraw, [&](auto& node) {
-                std::for_each(node->components.begin(), node->components.end(), [&](auto& c) {
-                    if(c->obj->parentLayer == &layerListItem && (!drawBounds.has_value() || SCollision::collide(drawBounds.value(), c->obj->get_world_bounds().value())) && c->obj->should_draw(drawData))
-                        c->obj->preDrawDataHolder = c->obj->calculate_predraw_data(drawData);
-                    else
-                        c->obj->preDrawDataHolder = std::nullopt;
-                });
-            });
-            parallel_loop_container(unsortedComponents, [&](auto& c) {
-                if(c->obj->parentLayer == &layerListItem && c->obj->get_world_bounds().has_value() && (!drawBounds.has_value() || SCollision::collide(drawBounds.value(), c->obj->get_world_bounds().value())) && c->obj->should_draw(drawData))
-                    c->obj->preDrawDataHolder = c->obj->calculate_predraw_data(drawData);
-                else
-                    c->obj->preDrawDataHolder = std::nullopt;
-            });
-            for(auto& node : nodesToDraw) {
-                for(auto& c : node->components) {
-                    if(c->obj->preDrawDataHolder.has_value())
-                        compsToDraw.emplace_back(c);
-                }
-            }
-            for(auto& c : unsortedComponents) {
-                if(c->obj->preDrawDataHolder.has_value())
-                    compsToDraw.emplace_back(c);
-            }
-            std::sort(compsToDraw.begin(), compsToDraw.end(), [](auto& a, auto& b) {
-                return a->pos < b->pos;
-            });
-            for(auto& c : compsToDraw)
-                c->obj->draw_with_predraw_data(canvas, drawData, c->obj->preDrawDataHolder.value());
+            auto layerCacheIt = windowCache.layerCaches.find(&layerListItem);
+            if(useLayerCaches && layerCacheIt != windowCache.layerCaches.end())
+                canvas->drawImage(layerCacheIt->second.surface->makeTemporaryImage(), 0, 0, {SkFilterMode::kNearest, SkMipmapMode::kNone}, nullptr);
+            else
+                draw_layer_components_to_canvas(layerListItem, canvas, drawData, drawBounds, nodesToDraw);
         }
-        canvas->restore();
+        if(drawInOffscreenLayer)
+            canvas->restore();
+    }
+}
+
+void DrawingProgramCache::draw_layer_components_to_canvas(const DrawingProgramLayerListItem& layerListItem, SkCanvas* canvas, const DrawData& drawData, const std::optional<SCollision::AABB<WorldScalar>>& drawBounds, const std::vector<std::shared_ptr<DrawingProgramCacheBVHNode>>& nodesToDraw) {
+    // Only this layer's components in each node are visited, and they're already in draw order
+    std::vector<std::pair<const DrawingProgramCacheBVHNode*, std::span<CanvasComponentContainer::ObjInfo* const>>> layerComponentsInNodes;
+    layerComponentsInNodes.reserve(nodesToDraw.size());
+    for(auto& node : nodesToDraw) {
+        auto layerComponents = get_layer_components_in_draw_order(node->components, &layerListItem);
+        if(!layerComponents.empty())
+            layerComponentsInNodes.emplace_back(node.get(), layerComponents);
+    }
+    std::chrono::steady_clock::time_point predrawTimeStart = std::chrono::steady_clock::now();
+    WorldScalar reducedQualityDrawMinimum = drawData.cam.c.inverseScale >> REDUCED_QUALITY_COMP_MIN_SHIFT;
+    parallel_loop_container(layerComponentsInNodes, [&](auto& nodeAndComponents) {
+        bool drawReducedQuality = nodeAndComponents.first->drawReducedQuality;
+        for(CanvasComponentContainer::ObjInfo* c : nodeAndComponents.second) {
+            if((!drawBounds.has_value() || SCollision::collide(drawBounds.value(), c->obj->get_world_bounds().value())) && (!drawReducedQuality || c->obj->coords.inverseScale > reducedQualityDrawMinimum) && c->obj->should_draw(drawData))
+                c->obj->preDrawDataHolder = c->obj->calculate_predraw_data(drawData, nodeAndComponents.first->camRelativeOrigin);
+            else
+                c->obj->preDrawDataHolder = std::nullopt;
+        }
+    });
+    parallel_loop_container(unsortedComponents, [&](auto& c) {
+        if(c->obj->parentLayer == &layerListItem && c->obj->get_world_bounds().has_value() && (!drawBounds.has_value() || SCollision::collide(drawBounds.value(), c->obj->get_world_bounds().value())) && c->obj->should_draw(drawData))
+            c->obj->preDrawDataHolder = c->obj->calculate_predraw_data(drawData);
+        else
+            c->obj->preDrawDataHolder = std::nullopt;
+    });
+    RenderStats::current().predrawTime += std::chrono::steady_clock::now() - predrawTimeStart;
+    // Unsorted components are the only ones that need sorting, and there are few of them
+    std::vector<CanvasComponentContainer::ObjInfo*> unsortedCompsToDraw;
+    for(auto& c : unsortedComponents) {
+        if(c->obj->preDrawDataHolder.has_value())
+            unsortedCompsToDraw.emplace_back(c);
     }
+    std::sort(unsortedCompsToDraw.begin(), unsortedCompsToDraw.end(), [](auto& a, auto& b) {
+        return a->pos < b->pos;
+    });
+
+    // Merge the sorted lists of components from each node with a heap of cursors, ordered by the position of the component each cursor is on
+    typedef std::span<CanvasComponentContainer::ObjInfo* const>::iterator ComponentIterator;
+    std::vector<std::pair<ComponentIterator, ComponentIterator>> cursors;
+    auto add_cursor = [&](std::span<CanvasComponentContainer::ObjInfo* const> comps) {
+        auto it = std::find_if(comps.begin(), comps.end(), [](auto& c) { return c->obj->preDrawDataHolder.has_value(); });
+        if(it != comps.end())
+            cursors.emplace_back(it, comps.end());
+    };
+    for(auto& [node, comps] : layerComponentsInNodes)
+        add_cursor(comps);
+    add_cursor(unsortedCompsToDraw);
+    RenderStats::current().unsortedComponentsDrawn += unsortedCompsToDraw.size();
+    auto cursorGreater = [](const auto& a, const auto& b) {
+        return (*a.first)->pos > (*b.first)->pos;
+    };
+    std::vector<CanvasComponentContainer::ObjInfo*> compsToDraw;
+    std::make_heap(cursors.begin(), cursors.end(), cursorGreater);
+    while(!cursors.empty()) {
+        std::pop_heap(cursors.begin(), cursors.end(), cursorGreater);
+        auto& [it, end] = cursors.back();
+        compsToDraw.emplace_back(*it);
+        it = std::find_if(std::next(it), end, [](auto& c) { return c->obj->preDrawDataHolder.has_value(); });
+        if(it == end)
+            cursors.pop_back();
+        else
+            std::push_heap(cursors.begin(), cursors.end(), cursorGreater);
+    }
+
+    if(USE_OCCLUSION_CULLING) {
+        size_t compsBeforeCulling = compsToDraw.size();
+        erase_occluded_components(compsToDraw, drawData);
+        RenderStats::current().componentsOccluded += compsBeforeCulling - compsToDraw.size();
+    }
+    CanvasComponentContainer::draw_components_with_predraw_data(canvas, drawData, compsToDraw);
 }
 
 void DrawingProgramCache::draw_cache_image_to_canvas(SkCanvas* canvas, const DrawData& drawData, const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode) {
@@ -492,7 +1485,7 @@ void DrawingProgramCache::draw_cache_image_to_canvas(SkCanvas* canvas, const Dra
         auto& nodeCache = it->second;
         canvas->save();
         bvhNode->coords.transform_sk_canvas(canvas, drawData);
-        nodeCache.lastRenderTime = std::chrono::steady_clock::now();
+        node_cache_lru_touch(*it);
 
         SkPaint srcPaint;
         srcPaint.setBlendMode(SkBlendMode::kSrc);
@@ -505,10 +1498,27 @@ void DrawingProgramCache::draw_cache_image_to_canvas(SkCanvas* canvas, const Dra
 
 void DrawingProgramCache::delete_all_draw_cache() {
     windowCache.surface = nullptr;
+    windowCache.scratchSurface = nullptr;
     windowCache.attachedDrawingProgramCache = nullptr;
-    nodeCacheMap.clear();
+    windowCache.layerCaches.clear();
+    windowCache.layerCachesValid = false;
+    while(nodeCacheLRUBack) {
+        std::shared_ptr<DrawingProgramCacheBVHNode> node = nodeCacheLRUBack->first;
+        erase_node_cache(node); // Also keeps the cached node counts in each tree correct
+    }
+    DrawingProgramTileCache::delete_all_tiles();
 }
 
 DrawingProgramCache::~DrawingProgramCache() {
+    // The running build stops at the next node once it's cancelled, so joining doesn't wait for the whole build
+    cancel_pending_build();
+    {
+        std::scoped_lock lock(buildWorkerMutex);
+        buildWorkerShutdown = true;
+        queuedBuild = nullptr;
+    }
+    buildQueuedCV.notify_one();
+    if(buildWorker.joinable())
+        buildWorker.join();
     clear_own_cached_surfaces();
 }
@@ -19,6 +19,10 @@
 #pragma once
 #include "../CanvasComponents/CanvasComponentContainer.hpp"
 #include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 struct DrawingProgramCacheBVHNode {
     public:
@@ -26,73 +30,261 @@ struct DrawingProgramCacheBVHNode {
         CoordSpaceHelper coords;
         Vector2i resolution;
     private:
-        std::vector<CanvasComponentContainer::ObjInfo*> components;
+        std::vector<CanvasComponentContainer::ObjInfo*> components; // Grouped by layer, and in draw order within each layer
         std::vector<std::shared_ptr<DrawingProgramCacheBVHNode>> children;
+        std::weak_ptr<DrawingProgramCacheBVHNode> parent;
+        std::optional<CanvasComponentContainer::CameraRelativeNodeOrigin> camRelativeOrigin; // Snapshot for the draw currently in progress
+        bool drawReducedQuality = false; // Set for the draw currently in progress, when the node has no surface yet because the refresh budget ran out
+        size_t cachedNodeCount = 0; // Nodes in this subtree (including this one) that have a cached surface, so that invalidation can skip subtrees without any
         friend class DrawingProgramCache;
 };
 
 class DrawingProgramCache {
     public:
-        static size_t MINIMUM_COMPONENTS_TO_START_REBUILD;
         static size_t MAXIMUM_COMPONENTS_IN_SINGLE_NODE;
-        static size_t MAXIMUM_DRAW_CACHE_SURFACES;
+        static size_t DRAW_CACHE_MEMORY_BUDGET_MB; // Shared by the cached node surfaces of every open canvas and the layer caches
         static size_t CACHE_NODE_RESOLUTION;
-        static size_t MILLISECOND_FRAME_TIME_TO_FORCE_CACHE_REFRESH;
-        static size_t MILLISECOND_MINIMUM_TIME_TO_CHECK_FORCE_REFRESH;
+        static size_t CACHE_REFRESH_BUDGET_MILLISECONDS; // Time per frame spent rendering stale node surfaces. At least one node is rendered per frame
+        static bool USE_SAH_BVH_BUILDER;
+        static bool USE_OCCLUSION_CULLING; // Skip drawing components that are completely under an opaque component in the same layer
+        static size_t MAXIMUM_CACHED_LAYERS; // Layers not being edited that are flattened into their own window sized surface while the camera is still. 0 disables layer caches
+        // Deferred nodes without a surface skip components that are drawn this many times (as a power of 2) smaller than their own scale
+        static constexpr int REDUCED_QUALITY_COMP_MIN_SHIFT = 6;
 
         DrawingProgramCache(DrawingProgram& initDrawP);
         void add_component(CanvasComponentContainer::ObjInfo* c);
         void erase_component(CanvasComponentContainer::ObjInfo* c);
         void clear_own_cached_surfaces();
+        // The window cache isn't kept up to date while the canvas is drawn from the tile cache, so it has to be redrawn before it's used again
+        void detach_window_cache();
         void preupdate_component(CanvasComponentContainer::ObjInfo* c);
+        // Called when a component is moved within its layer. The list can call this before the positions of the components after it
+        // are updated, so the node it's in is only sorted again in update_bvh
+        void update_component_draw_order(CanvasComponentContainer::ObjInfo* c);
+        // Rebuilds the tree on a worker thread from a snapshot of the component bounds. The current tree keeps being drawn
+        // until update_bvh swaps the new one in, so the components in the current tree must still be alive. Use clear_bvh first
+        // if they were deleted without going through erase_component
         void build(const std::unordered_set<CanvasComponentContainer::ObjInfo*>& objsToExclude);
-        void traverse_bvh_run_function(const SCollision::AABB<WorldScalar>& aabb, std::function<bool(const std::shared_ptr<DrawingProgramCacheBVHNode>& node)> f);
-        void traverse_bvh_run_function_starting_at_node(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, const SCollision::AABB<WorldScalar>& aabb, std::function<bool(const std::shared_ptr<DrawingProgramCacheBVHNode>& node)> f);
-        void traverse_bvh_run_function_starting_at_node_no_collision_check(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, std::function<bool(const std::shared_ptr<DrawingProgramCacheBVHNode>& node)> f);
-        void node_loop_erase_if_components(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, std::function<bool(CanvasComponentContainer::ObjInfo* comp)> f);
-        void node_loop_components(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, std::function<void(CanvasComponentContainer::ObjInfo* comp)> f);
-        bool should_rebuild() const;
-        bool check_rebuild_needed_from_framerate();
+        void clear_bvh();
+        // Scales the tree along with the canvas. Cached surfaces are kept, since everything they show is scaled by the same amount
+        void scale_up(const WorldScalar& scaleUpAmount);
+
+        // The traversal functions take the visitor as a template parameter instead of a std::function, since they're called for
+        // every node and component in the innermost loops of drawing, erasing and selecting. The visitor is called with a
+        // const std::shared_ptr<DrawingProgramCacheBVHNode>&, and returns whether the node's children should be visited too
+        template <typename F> void traverse_bvh_run_function(const SCollision::AABB<WorldScalar>& aabb, F&& f) {
+            static const std::shared_ptr<DrawingProgramCacheBVHNode> unsortedComponentsNode; // Visited as nullptr
+            f(unsortedComponentsNode);
+            traverse_bvh_run_function_starting_at_node(bvhRoot, aabb, f);
+        }
+        template <typename F> void traverse_bvh_run_function_starting_at_node(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, const SCollision::AABB<WorldScalar>& aabb, F&& f) {
+            if(bvhNode && SCollision::collide(aabb, bvhNode->bounds) && f(bvhNode)) {
+                for(auto& p : bvhNode->children)
+                    traverse_bvh_run_function_starting_at_node(p, aabb, f);
+            }
+        }
+        template <typename F> void traverse_bvh_run_function_starting_at_node_no_collision_check(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, F&& f) {
+            if(bvhNode && f(bvhNode)) {
+                for(auto& p : bvhNode->children)
+                    traverse_bvh_run_function_starting_at_node_no_collision_check(p, f);
+            }
+        }
+        // The visitor is called with each CanvasComponentContainer::ObjInfo* in the node (or the unsorted components if the node
+        // is nullptr), and returns whether to remove it from the cache
+        template <typename F> void node_loop_erase_if_components(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, F&& f) {
+            if(bvhNode) {
+                if(std::erase_if(bvhNode->components, [&](CanvasComponentContainer::ObjInfo* comp) {
+                    if(f(comp)) {
+                        comp->obj->cacheParentBvhNode.reset();
+                        mark_component_changed_since_snapshot(comp, false);
+                        return true;
+                    }
+                    return false;
+                }))
+                    nodesToRefit.emplace_back(bvhNode); // Can be called while traversing the tree, so nodes are only removed later in update_bvh
+            }
+            else {
+                std::erase_if(unsortedComponents, [&](CanvasComponentContainer::ObjInfo* comp) {
+                    if(f(comp)) {
+                        mark_component_changed_since_snapshot(comp, false);
+                        return true;
+                    }
+                    return false;
+                });
+            }
+        }
+        template <typename F> void node_loop_components(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, F&& f) {
+            for(CanvasComponentContainer::ObjInfo* comp : (bvhNode ? bvhNode->components : unsortedComponents))
+                f(comp);
+        }
+
+        // Swaps in a tree built by the worker thread if it's finished, inserts components added or changed since the last call into
+        // the tree, and removes nodes left empty by erased components. Should be called once per frame, before drawing
+        void update_bvh();
         void update_and_draw_cached_canvas(SkCanvas* canvas, const DrawData& drawData);
-        void draw_components_to_canvas(SkCanvas* canvas, const DrawData& drawData, const std::optional<SCollision::AABB<WorldScalar>>& drawBounds);
+        // approximateDeferredNodes draws the nodes left stale by the last refresh_all_draw_cache from their old surface, or at reduced
+        // quality if they don't have one yet. Only used for the window cache, which is redrawn over those nodes once they're rendered
+        void draw_components_to_canvas(SkCanvas* canvas, const DrawData& drawData, const std::optional<SCollision::AABB<WorldScalar>>& drawBounds, bool useLayerCaches = false, bool approximateDeferredNodes = false);
         void invalidate_cache_at_aabb(const SCollision::AABB<WorldScalar>& aabb);
         void invalidate_cache_at_optional_aabb(const std::optional<SCollision::AABB<WorldScalar>>& aabb);
+        // Same as invalidate_cache_at_optional_aabb with the component's bounds, except that only the layer cache of the component's layer is invalidated
+        void invalidate_cache_at_component(CanvasComponentContainer::ObjInfo* c);
         static void delete_all_draw_cache();
 
+        struct NodeCacheStats {
+            uint64_t hits = 0; // Node surface already existed when the node was refreshed
+            uint64_t misses = 0; // Node surface had to be allocated
+            uint64_t evictions = 0;
+            size_t bytesResident = 0; // Node surfaces only
+            size_t layerCacheBytesResident = 0;
+        };
+        static const NodeCacheStats& get_node_cache_stats();
+
+        // Index i holds the number of nodes with a component count in [2^(i - 1), 2^i), index 0 holds nodes without components
+        static std::vector<size_t> get_node_occupancy_histogram(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode);
+        // Builds both the quadtree and SAH trees over the current components and logs their occupancy histograms. Doesn't modify the cache
+        void log_bvh_occupancy_comparison() const;
+
         CanvasComponentContainer::ObjInfo* get_front_object_colliding_with_in_editing_layer(const SkPath& cC);
         ~DrawingProgramCache();
     private:
+        struct NodeCache;
+        typedef std::pair<const std::shared_ptr<DrawingProgramCacheBVHNode>, NodeCache> NodeCacheMapEntry;
         struct NodeCache {
             sk_sp<SkSurface> surface;
-            std::chrono::steady_clock::time_point lastRenderTime;
+            size_t surfaceBytes = 0;
             DrawingProgramCache* attachedDrawingProgramCache;
             std::optional<SCollision::AABB<WorldScalar>> invalidBounds;
+            // Links of the least recently used list through all entries in nodeCacheMap. Entries in an unordered_map keep their
+            // address until they're erased, so they can point at each other directly
+            NodeCacheMapEntry* lruPrev = nullptr;
+            NodeCacheMapEntry* lruNext = nullptr;
         };
         static std::unordered_map<std::shared_ptr<DrawingProgramCacheBVHNode>, NodeCache> nodeCacheMap;
+        static NodeCacheMapEntry* nodeCacheLRUFront; // Most recently used
+        static NodeCacheMapEntry* nodeCacheLRUBack; // Least recently used, evicted first
+        static NodeCacheStats nodeCacheStats;
+
+        static void emplace_node_cache(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, const NodeCache& nodeCache);
+        static void erase_node_cache(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode);
+        static void add_to_cached_node_counts(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, int64_t amount);
+        static void node_cache_lru_link_front(NodeCacheMapEntry& entry);
+        static void node_cache_lru_unlink(NodeCacheMapEntry& entry);
+        static void node_cache_lru_touch(NodeCacheMapEntry& entry);
+        static void evict_node_caches_to_fit(size_t bytesToFit);
+        static size_t get_layer_cache_bytes_resident();
+
+        struct LayerCache {
+            sk_sp<SkSurface> surface;
+            size_t surfaceBytes = 0;
+            std::optional<SCollision::AABB<WorldScalar>> invalidBounds;
+            bool drawn = false; // Drawn with the window cache's current camera. Layer caches are drawn over several frames
+        };
 
         struct WindowCache {
             sk_sp<SkSurface> surface;
             DrawingProgramCache* attachedDrawingProgramCache = nullptr;
             std::optional<SCollision::AABB<WorldScalar>> invalidBounds;
-            CoordSpaceHelper coords;
+            CoordSpaceHelper coords; // Camera the surface was drawn with. Can differ from the current camera while panning or previewing a zoom
+            CoordSpaceHelper lastFrameCamCoords; // Used to tell whether the camera is still moving
+            sk_sp<SkSurface> scratchSurface; // Target for shifting the surface while panning. Swapped with surface afterwards
+            // Layers that aren't being edited, each drawn alone with the same camera as surface. They aren't shifted while panning,
+            // so they're only used while layerCachesValid is set
+            std::unordered_map<const DrawingProgramLayerListItem*, LayerCache> layerCaches;
+            bool layerCachesValid = false;
+            const DrawingProgramLayerListItem* layerCachesEditingLayer = nullptr; // Layer being edited when the layer caches were drawn
         };
         static WindowCache windowCache;
 
+        struct BVHBuildComponent {
+            CanvasComponentContainer::ObjInfo* comp;
+            SCollision::AABB<WorldScalar> bounds;
+            CoordSpaceHelper coords;
+            // Draw order at the time of the snapshot. Components moved after it are marked as changed, so it's still correct for the rest
+            const DrawingProgramLayerListItem* layer;
+            uint32_t pos;
+        };
+        struct BVHComponentPlacement {
+            CanvasComponentContainer::ObjInfo* comp;
+            std::shared_ptr<DrawingProgramCacheBVHNode> node;
+            CanvasComponentContainer::NodeRelativeCoords relativeCoords;
+        };
+        // Copy of the static config used by a build, since the debug menu can change the static values while the worker thread runs
+        struct BVHBuildSettings {
+            bool useSAH;
+            size_t maxComponentsInSingleNode;
+            size_t nodeResolution;
+        };
+        struct BVHBuildJob {
+            // Only touched by the worker thread until finished is set
+            std::vector<BVHBuildComponent> components;
+            BVHBuildSettings settings;
+            std::shared_ptr<DrawingProgramCacheBVHNode> root;
+            std::vector<BVHComponentPlacement> placements;
+            std::atomic<bool> finished = false;
+            std::atomic<bool> cancelled = false; // Set when the build is abandoned, so the worker thread stops at the next node
+
+            // Only touched by the main thread
+            std::vector<CanvasComponentContainer::ObjInfo*> componentsWithoutBounds;
+            // Components added, erased, or moved since the snapshot, so the snapshot is out of date for them. Maps to whether the
+            // component is in the cache now, or nullopt if that didn't change
+            std::unordered_map<CanvasComponentContainer::ObjInfo*, std::optional<bool>> componentsChangedSinceSnapshot;
+            std::optional<WorldScalar> scaleUpAmountSinceSnapshot;
+        };
+
         void refresh_all_draw_cache(const DrawData& drawData);
-        void update_window_cache_invalid_bounds(const DrawData& drawData);
+        void update_window_cache_invalid_bounds(const DrawData& windowDrawData);
         void window_cache_complete_refresh(const DrawData& drawData);
+        void window_cache_refresh_area(const DrawData& windowDrawData, const SkIRect& area);
+        static std::optional<SkIRect> get_window_area_to_refresh(const DrawData& windowDrawData, const SCollision::AABB<WorldScalar>& invalidBounds);
+        bool update_layer_caches(const DrawData& drawData);
+        static void invalidate_layer_caches();
+        void layer_cache_refresh_area(const DrawingProgramLayerListItem& layerListItem, LayerCache& layerCache, const DrawData& drawData, const std::optional<SkIRect>& area);
+        void invalidate_cache_at_aabb_in_layer(const SCollision::AABB<WorldScalar>& aabb, const DrawingProgramLayerListItem* layer); // Invalidates the layer caches of every layer if layer is nullptr
+        bool window_cache_reproject_pan(const DrawData& drawData);
+        bool window_cache_can_preview_zoom(const DrawData& drawData) const;
+        DrawData get_window_cache_draw_data(const DrawData& drawData) const;
         void allocate_window_cache_area();
-        void internal_build(std::vector<CanvasComponentContainer::ObjInfo*> componentsToBuild, const std::unordered_set<CanvasComponentContainer::ObjInfo*>& objsToNotInclude);
-        void build_bvh_node(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, const std::vector<CanvasComponentContainer::ObjInfo*>& components);
-        void build_bvh_node_coords_and_resolution(DrawingProgramCacheBVHNode& node);
+        static void build_bvh_job(BVHBuildJob& job);
+        void build_worker_func();
+        void cancel_pending_build();
+        static BVHBuildSettings get_build_settings();
+        void swap_in_built_bvh();
+        void carry_over_node_caches(const std::shared_ptr<DrawingProgramCacheBVHNode>& newRoot);
+        void mark_component_changed_since_snapshot(CanvasComponentContainer::ObjInfo* c, std::optional<bool> isInCache);
+        static std::vector<BVHBuildComponent> get_build_components(const std::vector<CanvasComponentContainer::ObjInfo*>& components);
+        static std::vector<const BVHBuildComponent*> get_build_component_pointers(const std::vector<BVHBuildComponent>& buildComponents);
+        // cancelled is nullptr for builds on the main thread, which can't be abandoned
+        static void build_bvh_node(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, const std::vector<const BVHBuildComponent*>& components, const BVHBuildSettings& settings, std::vector<BVHComponentPlacement>& placements, const std::atomic<bool>* cancelled = nullptr);
+        static void split_components_quadtree(DrawingProgramCacheBVHNode& node, const std::vector<const BVHBuildComponent*>& components, std::vector<const BVHBuildComponent*>& componentsToKeep, std::vector<std::vector<const BVHBuildComponent*>>& parts);
+        static void split_components_sah(DrawingProgramCacheBVHNode& node, const std::vector<const BVHBuildComponent*>& components, size_t maxComponentsInSingleNode, std::vector<const BVHBuildComponent*>& componentsToKeep, std::vector<std::vector<const BVHBuildComponent*>>& parts);
+        static void add_components_to_node_in_draw_order(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, std::vector<const BVHBuildComponent*> components, std::vector<BVHComponentPlacement>& placements);
+        static void build_bvh_node_coords_and_resolution(DrawingProgramCacheBVHNode& node, size_t nodeResolution);
+        static void scale_up_bvh_node(DrawingProgramCacheBVHNode& node, const WorldScalar& scaleUpAmount);
+        static void apply_component_placements(const std::vector<BVHComponentPlacement>& placements);
+        void insert_component_into_bvh(CanvasComponentContainer::ObjInfo* c);
+        void grow_bvh_root(const SCollision::AABB<WorldScalar>& aabbToInclude);
+        void split_bvh_node_components(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode);
+        void refit_bvh_nodes();
+        void sort_moved_bvh_nodes();
+        static void set_component_parent_node(CanvasComponentContainer::ObjInfo* c, const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode);
         void refresh_draw_cache(const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode, const DrawData& drawData);
         void draw_cache_image_to_canvas(SkCanvas* canvas, const DrawData& drawData, const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode);
-        void recursive_draw_layer_item_to_canvas(const DrawingProgramLayerListItem& layerListItem, SkCanvas* canvas, const DrawData& drawData, const std::optional<SCollision::AABB<WorldScalar>>& drawBounds, const std::vector<std::shared_ptr<DrawingProgramCacheBVHNode>>& nodesToDraw);
-
-        std::optional<std::chrono::steady_clock::time_point> badFrametimeTimePoint;
-        std::optional<std::chrono::steady_clock::time_point> unorderedObjectsExistTimePoint;
+        void recursive_draw_layer_item_to_canvas(const DrawingProgramLayerListItem& layerListItem, SkCanvas* canvas, const DrawData& drawData, const std::optional<SCollision::AABB<WorldScalar>>& drawBounds, const std::vector<std::shared_ptr<DrawingProgramCacheBVHNode>>& nodesToDraw, bool useLayerCaches);
+        void draw_layer_components_to_canvas(const DrawingProgramLayerListItem& layerListItem, SkCanvas* canvas, const DrawData& drawData, const std::optional<SCollision::AABB<WorldScalar>>& drawBounds, const std::vector<std::shared_ptr<DrawingProgramCacheBVHNode>>& nodesToDraw);
 
         std::shared_ptr<DrawingProgramCacheBVHNode> bvhRoot;
-        std::vector<CanvasComponentContainer::ObjInfo*> unsortedComponents;
+        std::vector<CanvasComponentContainer::ObjInfo*> unsortedComponents; // Components without world bounds, and components added or changed since the last update_bvh call
+        std::vector<std::weak_ptr<DrawingProgramCacheBVHNode>> nodesToRefit; // Nodes that had components removed since the last update_bvh call
+        std::vector<std::weak_ptr<DrawingProgramCacheBVHNode>> nodesToSort; // Nodes that had components moved since the last update_bvh call
+        bool nodeRefreshPending = false; // Visible nodes were left stale last frame because the refresh budget ran out
+        std::shared_ptr<BVHBuildJob> pendingBuild; // Shared with the worker thread, so that an abandoned build can stop on its own
+
+        // Builds run one at a time on a worker thread owned by this cache. It's started with the first build, and joined in the destructor
+        std::thread buildWorker;
+        std::mutex buildWorkerMutex;
+        std::condition_variable buildQueuedCV;
+        std::shared_ptr<BVHBuildJob> queuedBuild; // Next build for the worker. Replaced if another build starts before the worker takes it
+        bool buildWorkerShutdown = false;
         DrawingProgram& drawP;
 };
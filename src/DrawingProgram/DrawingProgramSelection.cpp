@@ -252,6 +252,35 @@ void DrawingProgramSelection::check_add_stroke_color_change_undo() {
     }
 }
 
+auto DrawingProgramSelection::erase_select_objects_in_bvh_func(std::vector<CanvasComponentContainer::ObjInfo*>& selectedComponents, const SkPath& cC, DrawingProgramLayerManager::LayerSelector layerSelector) {
+    return [&](const std::shared_ptr<DrawingProgramCacheBVHNode>& bvhNode) {
+        if(bvhNode && (bvhNode->coords.inverseScale << 9) < drawP.world.drawData.cam.c.inverseScale &&
+           std::ranges::all_of(drawP.world.drawData.cam.c.aabb_corners_to_space(bvhNode->bounds), [&](const Vector2f& p) { return cC.contains(convert_vec2<SkPoint>(p)); })) {
+            drawP.drawCache.invalidate_cache_at_aabb(bvhNode->bounds);
+            drawP.drawCache.traverse_bvh_run_function_starting_at_node_no_collision_check(bvhNode, [&](const auto& bvhNodeChild) {
+                drawP.drawCache.node_loop_erase_if_components(bvhNodeChild, [&](auto c) {
+                    if(drawP.layerMan.component_passes_layer_selector(c, drawP.controls.layerSelector)) {
+                        selectedComponents.emplace_back(c);
+                        return true;
+                    }
+                    return false;
+                });
+                return true;
+            });
+            return false;
+        }
+        drawP.drawCache.node_loop_erase_if_components(bvhNode, [&](auto c) {
+            if(drawP.layerMan.component_passes_layer_selector(c, drawP.controls.layerSelector) && c->obj->collides_with(drawP.world.drawData.cam.c, cC)) {
+                selectedComponents.emplace_back(c);
+                drawP.drawCache.invalidate_cache_at_component(c);
+                return true;
+            }
+            return false;
+        });
+        return true;
+    };
+}
+
 void DrawingProgramSelection::add_from_cam_coord_collider_to_selection(const SkPath& cC, DrawingProgramLayerManager::LayerSelector layerSelector, bool frontObjectOnly) {
     check_add_stroke_color_change_undo();
 
@@ -293,40 +322,6 @@ void DrawingProgramSelection::remove_from_cam_coord_collider_to_selection(const
     calculate_aabb();
 }
 
-std::function<bool(const std::shared_ptr<DrawingProgramCacheBVHNode>&)> DrawingProgramSelection::erase_select_objects_in_bvh_func(std::vector<CanvasComponentContainer::ObjInfo*>& selectedComponents, const SkPath& cC, DrawingProgramLayerManager::LayerSelector layerSelector) {
-    auto toRet = [&](const auto& bvhNode) {
-        if(bvhNode && (bvhNode->coords.inverseScale << 9) < drawP.world.drawData.cam.c.inverseScale &&
-           cC.contains(convert_vec2<SkPoint>(drawP.world.drawData.cam.c.to_space(bvhNode->bounds.min))) &&
-           cC.contains(convert_vec2<SkPoint>(drawP.world.drawData.cam.c.to_space(bvhNode->bounds.max))) &&
-           cC.contains(convert_vec2<SkPoint>(drawP.world.drawData.cam.c.to_space(bvhNode->bounds.top_right()))) &&
-           cC.contains(convert_vec2<SkPoint>(drawP.world.drawData.cam.c.to_space(bvhNode->bounds.bottom_left())))) {
-            drawP.drawCache.invalidate_cache_at_aabb(bvhNode->bounds);
-            drawP.drawCache.traverse_bvh_run_function_starting_at_node_no_collision_check(bvhNode, [&](const auto& bvhNodeChild) {
-                drawP.drawCache.node_loop_erase_if_components(bvhNodeChild, [&](auto c) {
-                    if(drawP.layerMan.component_passes_layer_selector(c, drawP.controls.layerSelector)) {
-                        selectedComponents.emplace_back(c);
-                        return true;
-                    }
-                    return false;
-                });
-                return true;
-            });
-            return false;
-        }
-        drawP.drawCache.node_loop_erase_if_components(bvhNode, [&](auto c) {
-            if(drawP.layerMan.component_passes_layer_selector(c, drawP.controls.layerSelector) && c->obj->collides_with(drawP.world.drawData.cam.c, cC)) {
-                selectedComponents.emplace_back(c);
-                drawP.drawCache.invalidate_cache_at_optional_aabb(c->obj->get_world_bounds());
-                return true;
-            }
-            return false;
-        });
-        return true;
-    };
-
-    return toRet;
-}
-
 void DrawingProgramSelection::add_to_selection(const std::vector<CanvasComponentContainer::ObjInfo*>& newSelection) {
     selectedSet.insert(selectedSet.end(), newSelection.begin(), newSelection.end());
     sort_selection();
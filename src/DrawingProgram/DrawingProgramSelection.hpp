@@ -85,7 +85,8 @@ class DrawingProgramSelection {
         void calculate_aabb();
         void reset_all();
         void reset_transform_data();
-        std::function<bool(const std::shared_ptr<DrawingProgramCacheBVHNode>&)> erase_select_objects_in_bvh_func(std::vector<CanvasComponentContainer::ObjInfo*>& selectedComponents, const SkPath& cC, DrawingProgramLayerManager::LayerSelector layerSelector);
+        // Returns a visitor for DrawingProgramCache::traverse_bvh_run_function. Defined before its use in DrawingProgramSelection.cpp, since the return type is deduced
+        auto erase_select_objects_in_bvh_func(std::vector<CanvasComponentContainer::ObjInfo*>& selectedComponents, const SkPath& cC, DrawingProgramLayerManager::LayerSelector layerSelector);
 
         SCollision::ColliderCollection<float> camSpaceSelection;
         std::array<WorldVec, 4> selectionRectPoints;
@@ -0,0 +1,354 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "DrawingProgramTileCache.hpp"
+#include "DrawingProgram.hpp"
+#include "../World.hpp"
+#include "../MainProgram.hpp"
+#include "Helpers/ConvertVec.hpp"
+#include <include/core/SkPathBuilder.h>
+#include <chrono>
+#include <limits>
+
+bool DrawingProgramTileCache::USE_TILE_CACHE = false;
+#ifdef __EMSCRIPTEN__
+    size_t DrawingProgramTileCache::TILE_CACHE_MEMORY_BUDGET_MB = 256; // Use less VRAM in web build
+#else
+    size_t DrawingProgramTileCache::TILE_CACHE_MEMORY_BUDGET_MB = 512;
+#endif
+
+// Tiles are 2^TILE_RESOLUTION_SHIFT pixels wide
+static constexpr int32_t TILE_RESOLUTION_SHIFT = 9;
+static constexpr int TILE_RESOLUTION = 1 << TILE_RESOLUTION_SHIFT;
+static constexpr size_t TILE_BYTES = static_cast<size_t>(TILE_RESOLUTION) * static_cast<size_t>(TILE_RESOLUTION) * 4; // 4 bytes per pixel (RGBA)
+// A missing tile is drawn from an ancestor at most this many levels up, which is magnified 2^levels times
+static constexpr int32_t MAXIMUM_PLACEHOLDER_ANCESTOR_LEVELS = 4;
+
+std::map<DrawingProgramTileCache::TileKey, DrawingProgramTileCache::Tile> DrawingProgramTileCache::tileMap;
+DrawingProgramTileCache::TileMapEntry* DrawingProgramTileCache::tileLRUFront = nullptr;
+DrawingProgramTileCache::TileMapEntry* DrawingProgramTileCache::tileLRUBack = nullptr;
+size_t DrawingProgramTileCache::tileBytesResident = 0;
+
+// Index of the tile at this level that contains the coordinate. Shifting rounds towards negative infinity, so this is correct for negative coordinates too
+static WorldScalar tile_index_at(const WorldScalar& a, int32_t level) {
+    return FixedPoint::trunc(level >= 0 ? (a >> level) : (a << -level));
+}
+
+static void add_quad_to_path(SkPathBuilder& path, const std::array<Vector2f, 4>& corners) {
+    path.moveTo(convert_vec2<SkPoint>(corners[0]));
+    for(size_t i = 1; i < 4; i++)
+        path.lineTo(convert_vec2<SkPoint>(corners[i]));
+    path.close();
+}
+
+DrawingProgramTileCache::DrawingProgramTileCache(DrawingProgram& initDrawP):
+    drawP(initDrawP)
+{}
+
+bool DrawingProgramTileCache::TileKey::operator<(const TileKey& other) const {
+    if(owner != other.owner)
+        return owner < other.owner;
+    if(level != other.level)
+        return level < other.level;
+    if(index.x() != other.index.x())
+        return index.x() < other.index.x();
+    return index.y() < other.index.y();
+}
+
+WorldScalar DrawingProgramTileCache::get_tile_width(int32_t level) {
+    return level >= 0 ? (WorldScalar(1) << level) : (WorldScalar(1) >> -level);
+}
+
+SCollision::AABB<WorldScalar> DrawingProgramTileCache::get_tile_bounds(const TileKey& key) {
+    WorldScalar tileWidth = get_tile_width(key.level);
+    WorldVec tileMin = key.index * tileWidth;
+    return SCollision::AABB<WorldScalar>(tileMin, tileMin + WorldVec{tileWidth, tileWidth});
+}
+
+CoordSpaceHelper DrawingProgramTileCache::get_tile_coords(const TileKey& key) {
+    return CoordSpaceHelper(key.index * get_tile_width(key.level), get_tile_width(key.level - TILE_RESOLUTION_SHIFT), 0.0);
+}
+
+std::array<Vector2f, 4> DrawingProgramTileCache::get_tile_screen_corners(const DrawData& drawData, const SCollision::AABB<WorldScalar>& bounds) {
+    // Not just the min and max, since the camera can be rotated
+    return drawData.cam.c.aabb_corners_to_space(bounds);
+}
+
+int32_t DrawingProgramTileCache::get_level_for_camera(const DrawCamera& cam) {
+    // Tile pixels are the largest power of two that's no larger than a screen pixel, so tiles are shown at between half and full size
+    int32_t pixelSizeLog2 = FixedPoint::to_highest_bit(cam.c.inverseScale) - WorldScalar::bit_fraction_count();
+    return pixelSizeLog2 + TILE_RESOLUTION_SHIFT;
+}
+
+DrawingProgramTileCache::TileKey DrawingProgramTileCache::get_parent_key(const TileKey& key) {
+    return TileKey{key.owner, key.level + 1, WorldVec{tile_index_at(key.index.x(), 1), tile_index_at(key.index.y(), 1)}};
+}
+
+std::vector<DrawingProgramTileCache::TileKey> DrawingProgramTileCache::get_visible_tile_keys(const DrawData& drawData, int32_t level) {
+    const SCollision::AABB<WorldScalar>& viewBounds = drawData.cam.viewingAreaGenerousCollider;
+    WorldVec minIndex{tile_index_at(viewBounds.min.x(), level), tile_index_at(viewBounds.min.y(), level)};
+    WorldVec maxIndex{tile_index_at(viewBounds.max.x(), level), tile_index_at(viewBounds.max.y(), level)};
+    SCollision::AABB<float> screenBounds{Vector2f{0.0f, 0.0f}, drawData.cam.viewingArea};
+
+    std::vector<TileKey> toRet;
+    for(WorldScalar y = minIndex.y(); y <= maxIndex.y(); y += WorldScalar(1)) {
+        for(WorldScalar x = minIndex.x(); x <= maxIndex.x(); x += WorldScalar(1)) {
+            TileKey key{this, level, WorldVec{x, y}};
+            // The generous collider covers every rotation of the view, so skip the tiles in its corners that aren't on screen
+            std::array<Vector2f, 4> corners = get_tile_screen_corners(drawData, get_tile_bounds(key));
+            SCollision::AABB<float> tileScreenBounds{corners[0], corners[0]};
+            for(const Vector2f& corner : corners)
+                tileScreenBounds.include_point_in_bounds(corner);
+            if(SCollision::collide(tileScreenBounds, screenBounds))
+                toRet.emplace_back(key);
+        }
+    }
+
+    // Tiles closest to the center of the view are rendered first
+    Vector2f viewCenter = drawData.cam.viewingArea * 0.5f;
+    std::vector<WorldVec> tileCenters(toRet.size());
+    for(size_t i = 0; i < toRet.size(); i++)
+        tileCenters[i] = get_tile_bounds(toRet[i]).center();
+    std::vector<Vector2f> tileCentersOnScreen = drawData.cam.c.to_space(tileCenters);
+    std::vector<std::pair<float, TileKey>> keysByDistance;
+    keysByDistance.reserve(toRet.size());
+    for(size_t i = 0; i < toRet.size(); i++)
+        keysByDistance.emplace_back((tileCentersOnScreen[i] - viewCenter).squaredNorm(), toRet[i]);
+    std::sort(keysByDistance.begin(), keysByDistance.end(), [](auto& a, auto& b) {
+        return a.first < b.first;
+    });
+    for(size_t i = 0; i < toRet.size(); i++)
+        toRet[i] = keysByDistance[i].second;
+    return toRet;
+}
+
+void DrawingProgramTileCache::update_and_draw_cached_canvas(SkCanvas* canvas, const DrawData& drawData) {
+    int32_t level = get_level_for_camera(drawData.cam);
+    std::vector<TileKey> visibleKeys = get_visible_tile_keys(drawData, level);
+
+    // Render missing and invalid tiles until the refresh budget runs out. At least one tile is rendered per frame
+    auto refreshStart = std::chrono::steady_clock::now();
+    bool renderedTile = false;
+    for(auto& key : visibleKeys) {
+        if(find_valid_tile(key))
+            continue;
+        if(renderedTile && std::chrono::steady_clock::now() - refreshStart >= std::chrono::milliseconds(DrawingProgramCache::CACHE_REFRESH_BUDGET_MILLISECONDS))
+            break;
+        refresh_tile(key, drawData);
+        renderedTile = true;
+    }
+
+    // Tiles that are still missing are drawn from a parent or their children. Invalid tiles, and missing tiles without a
+    // placeholder, are drawn from their components, since there's no tile that shows them correctly
+    SkPathBuilder uncachedArea;
+    std::optional<SCollision::AABB<WorldScalar>> uncachedBounds;
+    for(auto& key : visibleKeys) {
+        auto it = tileMap.find(key);
+        if(it != tileMap.end() && !it->second.invalidBounds.has_value())
+            draw_tile_to_canvas(canvas, drawData, *it);
+        else if(it != tileMap.end() || !draw_placeholder_tiles(canvas, drawData, key)) {
+            SCollision::AABB<WorldScalar> tileBounds = get_tile_bounds(key);
+            add_quad_to_path(uncachedArea, get_tile_screen_corners(drawData, tileBounds));
+            if(uncachedBounds.has_value())
+                uncachedBounds.value().include_aabb_in_bounds(tileBounds);
+            else
+                uncachedBounds = tileBounds;
+        }
+    }
+    if(uncachedBounds.has_value()) {
+        canvas->save();
+        canvas->clipPath(uncachedArea.detach());
+        drawP.drawCache.draw_components_to_canvas(canvas, drawData, uncachedBounds);
+        canvas->restore();
+    }
+}
+
+DrawingProgramTileCache::TileMapEntry* DrawingProgramTileCache::find_valid_tile(const TileKey& key) {
+    auto it = tileMap.find(key);
+    if(it == tileMap.end() || it->second.invalidBounds.has_value())
+        return nullptr;
+    return &(*it);
+}
+
+bool DrawingProgramTileCache::draw_placeholder_tiles(SkCanvas* canvas, const DrawData& drawData, const TileKey& key) {
+    // Zooming in. The closest ancestor is magnified, and clipped to the area of this tile
+    TileKey ancestorKey = key;
+    for(int32_t i = 0; i < MAXIMUM_PLACEHOLDER_ANCESTOR_LEVELS; i++) {
+        ancestorKey = get_parent_key(ancestorKey);
+        TileMapEntry* ancestor = find_valid_tile(ancestorKey);
+        if(ancestor) {
+            SkPathBuilder tileArea;
+            add_quad_to_path(tileArea, get_tile_screen_corners(drawData, get_tile_bounds(key)));
+            canvas->save();
+            canvas->clipPath(tileArea.detach());
+            draw_tile_to_canvas(canvas, drawData, *ancestor);
+            canvas->restore();
+            return true;
+        }
+    }
+
+    // Zooming out. The four children cover this tile exactly, so they can only be used if all of them are there
+    std::array<TileMapEntry*, 4> children;
+    for(size_t i = 0; i < 4; i++) {
+        WorldVec childIndex = key.index * WorldScalar(2) + WorldVec{WorldScalar(static_cast<int32_t>(i & 1)), WorldScalar(static_cast<int32_t>(i >> 1))};
+        children[i] = find_valid_tile(TileKey{key.owner, key.level - 1, childIndex});
+        if(!children[i])
+            return false;
+    }
+    for(TileMapEntry* child : children)
+        draw_tile_to_canvas(canvas, drawData, *child);
+    return true;
+}
+
+void DrawingProgramTileCache::draw_tile_to_canvas(SkCanvas* canvas, const DrawData& drawData, TileMapEntry& entry) {
+    canvas->save();
+    get_tile_coords(entry.first).transform_sk_canvas(canvas, drawData);
+    tile_lru_touch(entry);
+    canvas->drawImage(entry.second.surface->makeTemporaryImage(), 0, 0, {SkFilterMode::kLinear, SkMipmapMode::kNone}, nullptr);
+    canvas->restore();
+}
+
+void DrawingProgramTileCache::refresh_tile(const TileKey& key, const DrawData& drawData) {
+    auto it = tileMap.find(key);
+    if(it == tileMap.end()) {
+        evict_tiles_to_fit(TILE_BYTES); // Evict before allocating, so that memory use never goes over the budget
+        Tile tile;
+        tile.surface = drawP.world.main.create_native_surface(Vector2i{TILE_RESOLUTION, TILE_RESOLUTION}, true);
+        tile.bounds = get_tile_bounds(key);
+        tile.invalidBounds = tile.bounds;
+        it = tileMap.emplace(key, tile).first;
+        tile_lru_link_front(*it);
+        tileBytesResident += TILE_BYTES;
+    }
+    else
+        tile_lru_touch(*it);
+
+    Tile& tile = it->second;
+    DrawData tileDrawData = drawData;
+    tileDrawData.cam.c = get_tile_coords(key);
+    tileDrawData.cam.set_viewing_area(Vector2f{TILE_RESOLUTION, TILE_RESOLUTION});
+    tileDrawData.refresh_draw_optimizing_values();
+
+    // Only the invalid area is redrawn. Tile coords aren't rotated, so the area stays axis aligned on the tile surface
+    SCollision::AABB<WorldScalar> iBounds = tile.bounds.get_intersection_between_aabbs(tile.invalidBounds.value());
+    SCollision::AABB<float> tileSpaceInvalidAABB = tileDrawData.cam.c.world_collider_to_coords<SCollision::AABB<float>>(iBounds);
+    SCollision::AABB<float> clipRectBoundAABB{tileSpaceInvalidAABB.min - Vector2f{4, 4}, tileSpaceInvalidAABB.max + Vector2f{4, 4}};
+    SCollision::AABB<WorldScalar> clipRectBoundAABBWorld = tileDrawData.cam.c.collider_to_world<SCollision::AABB<WorldScalar>>(clipRectBoundAABB);
+
+    SkCanvas* tileCanvas = tile.surface->getCanvas();
+    tileCanvas->save();
+    tileCanvas->clipIRect(SkIRect::MakeLTRB(clipRectBoundAABB.min.x(), clipRectBoundAABB.min.y(), clipRectBoundAABB.max.x(), clipRectBoundAABB.max.y()));
+    tileCanvas->clear(SkColor4f{0, 0, 0, 0});
+    drawP.drawCache.draw_components_to_canvas(tileCanvas, tileDrawData, clipRectBoundAABBWorld);
+    tileCanvas->restore();
+    tile.invalidBounds = std::nullopt;
+}
+
+void DrawingProgramTileCache::invalidate_cache_at_aabb(const SCollision::AABB<WorldScalar>& aabb) {
+    // Tiles are ordered by owner, then level, then index. In each level that has tiles, only the tiles in the range of indices
+    // covered by aabb are visited, by skipping ahead to the next column whenever a column's index range ends
+    auto it = tileMap.lower_bound(TileKey{this, std::numeric_limits<int32_t>::min(), WorldVec{0, 0}});
+    while(it != tileMap.end() && it->first.owner == this) {
+        int32_t level = it->first.level;
+        WorldVec minIndex{tile_index_at(aabb.min.x(), level), tile_index_at(aabb.min.y(), level)};
+        WorldVec maxIndex{tile_index_at(aabb.max.x(), level), tile_index_at(aabb.max.y(), level)};
+        it = tileMap.lower_bound(TileKey{this, level, minIndex});
+        while(it != tileMap.end() && it->first.owner == this && it->first.level == level && it->first.index.x() <= maxIndex.x()) {
+            const WorldVec& index = it->first.index;
+            if(index.y() < minIndex.y())
+                it = tileMap.lower_bound(TileKey{this, level, WorldVec{index.x(), minIndex.y()}});
+            else if(index.y() > maxIndex.y())
+                it = tileMap.lower_bound(TileKey{this, level, WorldVec{index.x() + WorldScalar(1), minIndex.y()}});
+            else {
+                Tile& tile = it->second;
+                if(SCollision::collide(aabb, tile.bounds)) {
+                    if(tile.invalidBounds.has_value())
+                        tile.invalidBounds.value().include_aabb_in_bounds(aabb);
+                    else
+                        tile.invalidBounds = aabb;
+                }
+                ++it;
+            }
+        }
+        if(it != tileMap.end() && it->first.owner == this && it->first.level == level)
+            it = tileMap.lower_bound(TileKey{this, level + 1, WorldVec{0, 0}});
+    }
+}
+
+void DrawingProgramTileCache::clear_own_tiles() {
+    for(auto it = tileMap.begin(); it != tileMap.end();) {
+        auto toErase = it++;
+        if(toErase->first.owner == this)
+            erase_tile(toErase);
+    }
+}
+
+void DrawingProgramTileCache::delete_all_tiles() {
+    while(tileLRUBack)
+        erase_tile(tileMap.find(tileLRUBack->first));
+}
+
+size_t DrawingProgramTileCache::get_tile_bytes_resident() {
+    return tileBytesResident;
+}
+
+void DrawingProgramTileCache::erase_tile(std::map<TileKey, Tile>::iterator it) {
+    tile_lru_unlink(*it);
+    tileBytesResident -= TILE_BYTES;
+    tileMap.erase(it);
+}
+
+void DrawingProgramTileCache::tile_lru_link_front(TileMapEntry& entry) {
+    entry.second.lruPrev = nullptr;
+    entry.second.lruNext = tileLRUFront;
+    if(tileLRUFront)
+        tileLRUFront->second.lruPrev = &entry;
+    else
+        tileLRUBack = &entry;
+    tileLRUFront = &entry;
+}
+
+void DrawingProgramTileCache::tile_lru_unlink(TileMapEntry& entry) {
+    if(entry.second.lruPrev)
+        entry.second.lruPrev->second.lruNext = entry.second.lruNext;
+    else
+        tileLRUFront = entry.second.lruNext;
+    if(entry.second.lruNext)
+        entry.second.lruNext->second.lruPrev = entry.second.lruPrev;
+    else
+        tileLRUBack = entry.second.lruPrev;
+    entry.second.lruPrev = nullptr;
+    entry.second.lruNext = nullptr;
+}
+
+void DrawingProgramTileCache::tile_lru_touch(TileMapEntry& entry) {
+    if(tileLRUFront != &entry) {
+        tile_lru_unlink(entry);
+        tile_lru_link_front(entry);
+    }
+}
+
+void DrawingProgramTileCache::evict_tiles_to_fit(size_t bytesToFit) {
+    size_t budgetBytes = TILE_CACHE_MEMORY_BUDGET_MB * 1024 * 1024;
+    while(tileLRUBack && tileBytesResident + bytesToFit > budgetBytes)
+        erase_tile(tileMap.find(tileLRUBack->first));
+}
+
+DrawingProgramTileCache::~DrawingProgramTileCache() {
+    clear_own_tiles();
+}
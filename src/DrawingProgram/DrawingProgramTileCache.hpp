@@ -0,0 +1,87 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "../DrawData.hpp"
+#include <include/core/SkCanvas.h>
+#include <include/core/SkSurface.h>
+#include <array>
+#include <map>
+
+class DrawingProgram;
+
+// Caches the canvas as a pyramid of square tiles in world space, like the tiles of a map. A tile at level L is 2^L world units wide,
+// and its children at level L - 1 split it into four. The camera draws with the level whose tiles are shown at between half and
+// full size, so zooming by a small amount reuses the same tiles. While a tile is rendering, its parent (or its children, when
+// zooming out) are drawn in its place
+class DrawingProgramTileCache {
+    public:
+        static bool USE_TILE_CACHE; // Draws the canvas from the tile cache instead of the window cache
+        static size_t TILE_CACHE_MEMORY_BUDGET_MB; // Shared by the tiles of every open canvas
+
+        DrawingProgramTileCache(DrawingProgram& initDrawP);
+        void update_and_draw_cached_canvas(SkCanvas* canvas, const DrawData& drawData);
+        // Called from the DrawingProgramCache invalidation functions, so the tiles are invalidated along with the cached nodes
+        void invalidate_cache_at_aabb(const SCollision::AABB<WorldScalar>& aabb);
+        void clear_own_tiles();
+        static void delete_all_tiles();
+        static size_t get_tile_bytes_resident();
+        ~DrawingProgramTileCache();
+    private:
+        struct TileKey {
+            DrawingProgramTileCache* owner; // Tiles of every canvas are in one map, so they can share one memory budget
+            int32_t level;
+            WorldVec index; // In tile widths from the world origin
+            bool operator<(const TileKey& other) const;
+        };
+        struct Tile;
+        typedef std::pair<const TileKey, Tile> TileMapEntry;
+        struct Tile {
+            sk_sp<SkSurface> surface;
+            SCollision::AABB<WorldScalar> bounds;
+            std::optional<SCollision::AABB<WorldScalar>> invalidBounds;
+            // Least recently used list, same as the one for cached nodes in DrawingProgramCache
+            TileMapEntry* lruPrev = nullptr;
+            TileMapEntry* lruNext = nullptr;
+        };
+        static std::map<TileKey, Tile> tileMap;
+        static TileMapEntry* tileLRUFront;
+        static TileMapEntry* tileLRUBack;
+        static size_t tileBytesResident;
+
+        static WorldScalar get_tile_width(int32_t level);
+        static SCollision::AABB<WorldScalar> get_tile_bounds(const TileKey& key);
+        static CoordSpaceHelper get_tile_coords(const TileKey& key);
+        static std::array<Vector2f, 4> get_tile_screen_corners(const DrawData& drawData, const SCollision::AABB<WorldScalar>& bounds);
+        static int32_t get_level_for_camera(const DrawCamera& cam);
+        static TileKey get_parent_key(const TileKey& key);
+        std::vector<TileKey> get_visible_tile_keys(const DrawData& drawData, int32_t level);
+
+        static TileMapEntry* find_valid_tile(const TileKey& key);
+        bool draw_placeholder_tiles(SkCanvas* canvas, const DrawData& drawData, const TileKey& key);
+        void draw_tile_to_canvas(SkCanvas* canvas, const DrawData& drawData, TileMapEntry& entry);
+        void refresh_tile(const TileKey& key, const DrawData& drawData);
+
+        static void erase_tile(std::map<TileKey, Tile>::iterator it);
+        static void tile_lru_link_front(TileMapEntry& entry);
+        static void tile_lru_unlink(TileMapEntry& entry);
+        static void tile_lru_touch(TileMapEntry& entry);
+        static void evict_tiles_to_fit(size_t bytesToFit);
+
+        DrawingProgram& drawP;
+};
@@ -25,8 +25,15 @@
 #include <Helpers/Logger.hpp>
 
 void DrawingProgramLayer::draw(SkCanvas* canvas, const DrawData& drawData) const {
-    for(auto& p : *components)
-        p.obj->draw(canvas, drawData);
+    std::vector<CanvasComponentContainer::ObjInfo*> compsToDraw;
+    for(auto& p : *components) {
+        if(p.obj->should_draw(drawData))
+            compsToDraw.emplace_back(&p);
+    }
+    parallel_loop_container(compsToDraw, [&](CanvasComponentContainer::ObjInfo* c) {
+        c->obj->preDrawDataHolder = c->obj->calculate_predraw_data(drawData);
+    });
+    CanvasComponentContainer::draw_components_with_predraw_data(canvas, drawData, compsToDraw);
 }
 
 void DrawingProgramLayer::set_component_list_callbacks(DrawingProgramLayerListItem& layerListItem, DrawingProgramLayerManager& layerMan) {
@@ -52,7 +59,8 @@ void DrawingProgramLayer::set_component_list_callbacks(DrawingProgramLayerListIt
     components->set_insert_callback(insertCallback);
     components->set_erase_callback(eraseCallback);
     components->set_move_callback([&](const CanvasComponentContainer::ObjInfoIterator& c, uint32_t oldPos) {
-        layerMan.drawP.drawCache.invalidate_cache_at_optional_aabb(c->obj->get_world_bounds());
+        layerMan.drawP.drawCache.invalidate_cache_at_component(&(*c));
+        layerMan.drawP.drawCache.update_component_draw_order(&(*c));
         if(layerMan.drawP.selection.is_selected(&(*c)))
             layerMan.drawP.selection.sort_selection(); // If item is selected, selected items will be unordered, so sort everything again
     });
@@ -22,6 +22,7 @@
 #include "DrawingProgramLayer.hpp"
 #include "../../World.hpp"
 #include "SerializedBlendMode.hpp"
+#include "../../RenderStats.hpp"
 
 using namespace NetworkingObjects;
 
@@ -211,11 +212,13 @@ void DrawingProgramLayerListItem::get_used_resources(std::unordered_set<Networki
 
 void DrawingProgramLayerListItem::draw(SkCanvas* canvas, const DrawData& drawData) const {
     if(displayData->visible) {
-        if(!drawData.isSVGRender) {
+        bool drawInOffscreenLayer = !drawData.isSVGRender && needs_offscreen_layer();
+        if(drawInOffscreenLayer) {
             SkPaint layerPaint;
             layerPaint.setAlphaf(displayData->alpha);
             layerPaint.setBlendMode(serialized_blend_mode_to_sk_blend_mode(displayData->blendMode));
             canvas->saveLayer(nullptr, &layerPaint);
+            RenderStats::current().saveLayerCount++;
         }
 
         if(folderData)
@@ -223,7 +226,7 @@ void DrawingProgramLayerListItem::draw(SkCanvas* canvas, const DrawData& drawDat
         else
             layerData->draw(canvas, drawData);
 
-        if(!drawData.isSVGRender)
+        if(drawInOffscreenLayer)
             canvas->restore();
     }
 }
@@ -275,6 +278,19 @@ SerializedBlendMode DrawingProgramLayerListItem::get_blend_mode() const {
     return displayData->blendMode;
 }
 
+bool DrawingProgramLayerListItem::needs_offscreen_layer() const {
+    bool hasVisibleChildWithOtherBlendMode = false;
+    if(folderData) {
+        for(auto& p : *folderData->folderList) {
+            if(p.obj->get_visible() && p.obj->get_blend_mode() != SerializedBlendMode::BLEND_SRC_OVER) {
+                hasVisibleChildWithOtherBlendMode = true;
+                break;
+            }
+        }
+    }
+    return layer_needs_offscreen_layer(displayData->alpha, displayData->blendMode, hasVisibleChildWithOtherBlendMode);
+}
+
 void DrawingProgramLayerListItem::set_metainfo(DrawingProgramLayerManager& layerMan, const DrawingProgramLayerListItemMetaInfo& metaInfo) {
     set_blend_mode(layerMan, metaInfo.blendMode);
     set_alpha(layerMan, metaInfo.alpha);
@@ -80,6 +80,9 @@ class DrawingProgramLayerListItem {
         void set_blend_mode(DrawingProgramLayerManager& layerMan, SerializedBlendMode newBlendMode) const;
         SerializedBlendMode get_blend_mode() const;
 
+        // False when drawing straight into the parent gives the same result as drawing into an offscreen layer first
+        bool needs_offscreen_layer() const;
+
         void set_metainfo(DrawingProgramLayerManager& layerMan, const DrawingProgramLayerListItemMetaInfo& metaInfo);
         DrawingProgramLayerListItemMetaInfo get_metainfo() const;
 
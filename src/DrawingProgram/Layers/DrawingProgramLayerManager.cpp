@@ -56,6 +56,7 @@ void DrawingProgramLayerManager::read_components_client(cereal::PortableBinaryIn
     parallel_loop_container(flattenedCompList, [&drawP = drawP](CanvasComponentContainer::ObjInfo* comp) {
         comp->obj->commit_update_dont_invalidate_cache(drawP);
     });
+    drawP.drawCache.clear_bvh(); // The components in the old tree were deleted along with the old layer tree
     drawP.rebuild_cache();
     editingLayer = layerTreeRoot->get_folder().get_initial_editing_layer();
 }
@@ -64,6 +65,10 @@ bool DrawingProgramLayerManager::is_a_layer_being_edited() {
     return !editingLayer.expired();
 }
 
+const DrawingProgramLayerListItem* DrawingProgramLayerManager::get_layer_being_edited() {
+    return editingLayer.lock().get();
+}
+
 uint32_t DrawingProgramLayerManager::edited_layer_component_count() {
     return editingLayer.lock()->get_layer().components->size();
 }
@@ -309,6 +314,7 @@ void DrawingProgramLayerManager::load_file(cereal::PortableBinaryInputArchive& a
         comp->obj->commit_update_dont_invalidate_cache(drawP);
     });
     layerTreeRoot->erase_invalid_components();
+    drawP.drawCache.clear_bvh(); // The components in the old tree were deleted along with the old layer tree
     drawP.rebuild_cache();
     editingLayer = layerTreeRoot->get_folder().get_initial_editing_layer();
 }
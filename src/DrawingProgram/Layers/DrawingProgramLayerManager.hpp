@@ -48,6 +48,7 @@ class DrawingProgramLayerManager {
         void write_components_server(cereal::PortableBinaryOutputArchive& a);
         void read_components_client(cereal::PortableBinaryInputArchive& a);
         bool is_a_layer_being_edited();
+        const DrawingProgramLayerListItem* get_layer_being_edited(); // nullptr if no layer is being edited
         void scale_up(const WorldScalar& scaleUpAmount);
         template <typename List> void erase_component_container(const List& compsToErase, bool newUndo = true) {
             if(!compsToErase.empty()) {
@@ -24,6 +24,10 @@ SkBlendMode serialized_blend_mode_to_sk_blend_mode(SerializedBlendMode serialize
     return static_cast<SkBlendMode>(skBlendModeStartVal + static_cast<uint8_t>(serializedBlendMode));
 }
 
+bool layer_needs_offscreen_layer(float alpha, SerializedBlendMode blendMode, bool hasVisibleChildWithOtherBlendMode) {
+    return alpha != 1.0f || blendMode != SerializedBlendMode::BLEND_SRC_OVER || hasVisibleChildWithOtherBlendMode;
+}
+
 const std::vector<SerializedBlendMode>& get_blend_mode_useful_list() {
     static std::vector<SerializedBlendMode> blendModeList;
     if(blendModeList.empty()) {
@@ -87,5 +87,8 @@ NLOHMANN_JSON_SERIALIZE_ENUM(SerializedBlendMode, {
 })
 
 SkBlendMode serialized_blend_mode_to_sk_blend_mode(SerializedBlendMode serializedBlendMode);
+// Whether a layer or folder with this alpha and blend mode gives a different result when drawn straight into its parent, instead of
+// into an offscreen layer first. A visible child with another blend mode should only blend with what's in its folder
+bool layer_needs_offscreen_layer(float alpha, SerializedBlendMode blendMode, bool hasVisibleChildWithOtherBlendMode);
 const std::vector<SerializedBlendMode>& get_blend_mode_useful_list();
 const std::vector<std::string>& get_blend_mode_useful_name_list();
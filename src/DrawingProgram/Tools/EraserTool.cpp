@@ -131,11 +131,7 @@ void EraserTool::erase_on_path() {
     if(eraseScaleToCheckAgainst == WorldScalar(0))
         return;
     drawP.drawCache.traverse_bvh_run_function(cCWorldBounds, [&](const auto& bvhNode) {
-        if(bvhNode &&
-           erasePath.contains(convert_vec2<SkPoint>(genData.coords.to_space(bvhNode->bounds.min))) &&
-           erasePath.contains(convert_vec2<SkPoint>(genData.coords.to_space(bvhNode->bounds.max))) &&
-           erasePath.contains(convert_vec2<SkPoint>(genData.coords.to_space(bvhNode->bounds.top_right()))) &&
-           erasePath.contains(convert_vec2<SkPoint>(genData.coords.to_space(bvhNode->bounds.bottom_left())))) {
+        if(bvhNode && std::ranges::all_of(genData.coords.aabb_corners_to_space(bvhNode->bounds), [&](const Vector2f& p) { return erasePath.contains(convert_vec2<SkPoint>(p)); })) {
             drawP.drawCache.invalidate_cache_at_aabb(bvhNode->bounds);
             drawP.drawCache.traverse_bvh_run_function_starting_at_node_no_collision_check(bvhNode, [&](const auto& bvhNodeChild) {
                 drawP.drawCache.node_loop_erase_if_components(bvhNodeChild, [&](auto c) {
@@ -170,10 +166,10 @@ void EraserTool::erase_on_path() {
                             }
                             // NOTE: commit_update is what should be run here, but invalidate_cache is being run instead. This is for a few reasons:
                             // - Mesh initialize_draw_data does nothing, so commit_update isnt necessary
-                            // - worldAABB only shrinks, which means that invalidate_cache_at_optional_aabb will invalidate a "good enough" space even if worldAABB isn't updated (which commit_update does)
+                            // - worldAABB only shrinks, which means that invalidate_cache_at_component will invalidate a "good enough" space even if worldAABB isn't updated (which commit_update does)
                             // - commit_update can't be run inside a traverse_bvh_run_function call (causes segfault and other issues). If that were necessary, we would have to defer that call for after the traversal is done
                             // - commit_update will be run at commit_erase time instead
-                            drawP.drawCache.invalidate_cache_at_optional_aabb(c->obj->get_world_bounds());
+                            drawP.drawCache.invalidate_cache_at_component(c);
                             return false;
                         }
                         case CanvasComponentEraseDetailResult::REMOVED: {
@@ -187,7 +183,7 @@ void EraserTool::erase_on_path() {
                                 c->obj->get_comp().set_data_from(*dataCopy->obj);
 
                             erasedComponents.emplace(c);
-                            drawP.drawCache.invalidate_cache_at_optional_aabb(c->obj->get_world_bounds());
+                            drawP.drawCache.invalidate_cache_at_component(c);
                             return true;
                         }
                     }
@@ -196,7 +192,7 @@ void EraserTool::erase_on_path() {
             else {
                 if(drawP.layerMan.component_passes_layer_selector(c, drawP.controls.layerSelector) && c->obj->collides_with(genData.coords, erasePath)) {
                     erasedComponents.emplace(c);
-                    drawP.drawCache.invalidate_cache_at_optional_aabb(c->obj->get_world_bounds());
+                    drawP.drawCache.invalidate_cache_at_component(c);
                     return true;
                 }
             }
@@ -320,7 +316,7 @@ void EraserTool::draw(SkCanvas* canvas, const DrawData& drawData) {
     bool overGuiRequirement = !drawData.main->g.gui.cursor_obstructed() || isErasing;
     if(touchDeviceRequirement && overGuiRequirement && !erasePath.isEmpty() && drawData.main->window.mouseFocus) {
         if(isErasing) {
-            CanvasComponentContainer::TransformData drawTransform = CanvasComponentContainer::calculate_draw_transform(drawData.cam.c, genData.coords);
+            CanvasComponentContainer::TransformData drawTransform = ComponentDrawTransform::calculate_draw_transform(drawData.cam.c, genData.coords);
             canvas->save();
             CanvasComponentContainer::canvas_do_transform(canvas, drawTransform);
         }
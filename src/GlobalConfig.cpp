@@ -21,6 +21,10 @@
 #include "Helpers/StringHelpers.hpp"
 #include "ResourceDisplay/ImageResourceDisplay.hpp"
 #include "DrawingProgram/DrawingProgramCache.hpp"
+#include "DrawingProgram/DrawingProgramTileCache.hpp"
+#include "RenderStats.hpp"
+#include "CanvasComponents/MeshCanvasComponent.hpp"
+#include "CanvasComponents/TextBoxCanvasComponent.hpp"
 #include <SDL3/SDL_time.h>
 
 GlobalConfig::GlobalConfig() {
@@ -88,11 +92,19 @@ nlohmann::json GlobalConfig::get_config_json(const InputManager& input) const {
     debugJson["jumpTransitionEasing"] = jumpTransitionEasing;
     debugJson["imageLoadMaxThreads"] = ImageResourceDisplay::IMAGE_LOAD_THREAD_COUNT_MAX;
     debugJson["cacheNodeResolution"] = DrawingProgramCache::CACHE_NODE_RESOLUTION;
-    debugJson["maxCacheNodes"] = DrawingProgramCache::MAXIMUM_DRAW_CACHE_SURFACES;
+    debugJson["cacheMemoryBudgetMB"] = DrawingProgramCache::DRAW_CACHE_MEMORY_BUDGET_MB;
+    debugJson["cacheRefreshBudgetMs"] = DrawingProgramCache::CACHE_REFRESH_BUDGET_MILLISECONDS;
     debugJson["maxComponentsInNode"] = DrawingProgramCache::MAXIMUM_COMPONENTS_IN_SINGLE_NODE;
-    debugJson["componentCountToForceCacheRebuild"] = DrawingProgramCache::MINIMUM_COMPONENTS_TO_START_REBUILD;
-    debugJson["maximumFrameTimeToForceCacheRebuild"] = DrawingProgramCache::MILLISECOND_FRAME_TIME_TO_FORCE_CACHE_REFRESH;
-    debugJson["millisecondMinimumTimeToCheckForCacheRebuild"] = DrawingProgramCache::MILLISECOND_MINIMUM_TIME_TO_CHECK_FORCE_REFRESH;
+    debugJson["useSAHCacheBuilder"] = DrawingProgramCache::USE_SAH_BVH_BUILDER;
+    debugJson["maxCachedLayers"] = DrawingProgramCache::MAXIMUM_CACHED_LAYERS;
+    debugJson["useOcclusionCulling"] = DrawingProgramCache::USE_OCCLUSION_CULLING;
+    debugJson["showRenderStats"] = RenderStats::SHOW_OVERLAY;
+    debugJson["useBatchedMeshDraw"] = MeshCanvasComponent::USE_BATCHED_DRAW;
+    debugJson["useMeshLOD"] = MeshCanvasComponent::USE_LOD;
+    debugJson["textGreekingPixelHeight"] = TextBoxCanvasComponent::GREEKING_PIXEL_HEIGHT;
+    debugJson["useTileCache"] = DrawingProgramTileCache::USE_TILE_CACHE;
+    debugJson["tileCacheMemoryBudgetMB"] = DrawingProgramTileCache::TILE_CACHE_MEMORY_BUDGET_MB;
+    debugJson["resourceCacheMemoryBudgetMB"] = ResourceDisplay::RESOURCE_CACHE_MEMORY_BUDGET_MB;
     toRet["debug"] = debugJson;
 
     return toRet;
@@ -163,11 +175,19 @@ void GlobalConfig::set_config_json(InputManager& input, const nlohmann::json& j,
     try{j.at("debug").at("jumpTransitionEasing").get_to(jumpTransitionEasing);} catch(...) {}
     try{j.at("debug").at("imageLoadMaxThreads").get_to(ImageResourceDisplay::IMAGE_LOAD_THREAD_COUNT_MAX);} catch(...) {}
     try{j.at("debug").at("cacheNodeResolution").get_to(DrawingProgramCache::CACHE_NODE_RESOLUTION);} catch(...) {}
-    try{j.at("debug").at("maxCacheNodes").get_to(DrawingProgramCache::MAXIMUM_DRAW_CACHE_SURFACES);} catch(...) {}
+    try{j.at("debug").at("cacheMemoryBudgetMB").get_to(DrawingProgramCache::DRAW_CACHE_MEMORY_BUDGET_MB);} catch(...) {}
+    try{j.at("debug").at("cacheRefreshBudgetMs").get_to(DrawingProgramCache::CACHE_REFRESH_BUDGET_MILLISECONDS);} catch(...) {}
     try{j.at("debug").at("maxComponentsInNode").get_to(DrawingProgramCache::MAXIMUM_COMPONENTS_IN_SINGLE_NODE);} catch(...) {}
-    try{j.at("debug").at("componentCountToForceCacheRebuild").get_to(DrawingProgramCache::MINIMUM_COMPONENTS_TO_START_REBUILD);} catch(...) {}
-    try{j.at("debug").at("maximumFrameTimeToForceCacheRebuild").get_to(DrawingProgramCache::MILLISECOND_FRAME_TIME_TO_FORCE_CACHE_REFRESH);} catch(...) {}
-    try{j.at("debug").at("millisecondMinimumTimeToCheckForCacheRebuild").get_to(DrawingProgramCache::MILLISECOND_MINIMUM_TIME_TO_CHECK_FORCE_REFRESH);} catch(...) {}
+    try{j.at("debug").at("useSAHCacheBuilder").get_to(DrawingProgramCache::USE_SAH_BVH_BUILDER);} catch(...) {}
+    try{j.at("debug").at("maxCachedLayers").get_to(DrawingProgramCache::MAXIMUM_CACHED_LAYERS);} catch(...) {}
+    try{j.at("debug").at("useOcclusionCulling").get_to(DrawingProgramCache::USE_OCCLUSION_CULLING);} catch(...) {}
+    try{j.at("debug").at("showRenderStats").get_to(RenderStats::SHOW_OVERLAY);} catch(...) {}
+    try{j.at("debug").at("useBatchedMeshDraw").get_to(MeshCanvasComponent::USE_BATCHED_DRAW);} catch(...) {}
+    try{j.at("debug").at("useMeshLOD").get_to(MeshCanvasComponent::USE_LOD);} catch(...) {}
+    try{j.at("debug").at("textGreekingPixelHeight").get_to(TextBoxCanvasComponent::GREEKING_PIXEL_HEIGHT);} catch(...) {}
+    try{j.at("debug").at("useTileCache").get_to(DrawingProgramTileCache::USE_TILE_CACHE);} catch(...) {}
+    try{j.at("debug").at("tileCacheMemoryBudgetMB").get_to(DrawingProgramTileCache::TILE_CACHE_MEMORY_BUDGET_MB);} catch(...) {}
+    try{j.at("debug").at("resourceCacheMemoryBudgetMB").get_to(ResourceDisplay::RESOURCE_CACHE_MEMORY_BUDGET_MB);} catch(...) {}
 }
 
 void GlobalConfig::save_palettes() {
@@ -19,6 +19,7 @@
 #include "MainProgram.hpp"
 #include "CustomEvents.hpp"
 #include "VersionConstants.hpp"
+#include "RenderStats.hpp"
 #include <SDL3/SDL_render.h>
 #include <SDL3/SDL_video.h>
 #include <include/core/SkAlphaType.h>
@@ -317,6 +318,8 @@ void MainProgram::draw_world(SkCanvas* canvas, std::shared_ptr<World> worldToDra
 void MainProgram::draw(SkCanvas* canvas) {
     screen->draw(canvas);
     g.draw(canvas, conf.antialiasing == GlobalConfig::AntiAliasing::SKIA);
+    if(RenderStats::SHOW_OVERLAY)
+        RenderStats::draw_overlay(canvas, g.gui.io.get_font(g.final_gui_scale() * g.gui.io.fontSize));
 }
 
 sk_sp<SkSurface> MainProgram::create_native_surface(Vector2i resolution, bool isMSAA) {
@@ -0,0 +1,99 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "RenderStats.hpp"
+#include <Helpers/Logger.hpp>
+#include <include/core/SkFontMetrics.h>
+#include <SDL3/SDL_iostream.h>
+#include <vector>
+
+bool RenderStats::SHOW_OVERLAY = false;
+RenderStats::Frame RenderStats::currentFrame;
+RenderStats::Frame RenderStats::lastFrame;
+
+static double duration_to_milliseconds(const std::chrono::steady_clock::duration& d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+RenderStats::Frame& RenderStats::current() {
+    return currentFrame;
+}
+
+const RenderStats::Frame& RenderStats::last() {
+    return lastFrame;
+}
+
+void RenderStats::end_frame() {
+    lastFrame = std::move(currentFrame);
+    currentFrame = Frame();
+}
+
+nlohmann::json RenderStats::frame_to_json(const Frame& frame) {
+    nlohmann::json toRet;
+    toRet["bvhNodesVisited"] = frame.bvhNodesVisited;
+    toRet["bvhNodesDrawnFromCache"] = frame.bvhNodesDrawnFromCache;
+    toRet["bvhNodesRerendered"] = frame.bvhNodesRerendered;
+    toRet["componentsDrawn"] = frame.componentsDrawn;
+    toRet["unsortedComponentsDrawn"] = frame.unsortedComponentsDrawn;
+    toRet["componentsOccluded"] = frame.componentsOccluded;
+    toRet["meshTrianglesSubmitted"] = frame.meshTrianglesSubmitted;
+    toRet["saveLayerCount"] = frame.saveLayerCount;
+    nlohmann::json mipmapLevelsJson = nlohmann::json::object();
+    for(auto& [level, count] : frame.imageMipmapLevelDraws)
+        mipmapLevelsJson[std::to_string(level)] = count;
+    toRet["imageMipmapLevelDraws"] = mipmapLevelsJson;
+    toRet["updateMs"] = duration_to_milliseconds(frame.updateTime);
+    toRet["predrawMs"] = duration_to_milliseconds(frame.predrawTime);
+    toRet["drawMs"] = duration_to_milliseconds(frame.drawTime);
+    toRet["flushMs"] = duration_to_milliseconds(frame.flushTime);
+    return toRet;
+}
+
+void RenderStats::dump_last_frame(const std::filesystem::path& filePath) {
+    std::string statsJson = frame_to_json(lastFrame).dump(4);
+    Logger::get().log(Logger::LogType::INFO, "[RenderStats::dump_last_frame] " + statsJson);
+    if(!SDL_SaveFile(filePath.string().c_str(), statsJson.c_str(), statsJson.size()))
+        Logger::get().log(Logger::LogType::INFO, "[RenderStats::dump_last_frame] Could not write " + filePath.string());
+}
+
+void RenderStats::draw_overlay(SkCanvas* canvas, const SkFont& font) {
+    std::vector<std::string> lines;
+    lines.emplace_back("Update / predraw / draw / flush (ms): " + std::to_string(duration_to_milliseconds(lastFrame.updateTime)) + " / " + std::to_string(duration_to_milliseconds(lastFrame.predrawTime)) + " / " + std::to_string(duration_to_milliseconds(lastFrame.drawTime)) + " / " + std::to_string(duration_to_milliseconds(lastFrame.flushTime)));
+    lines.emplace_back("Nodes visited / from cache / rerendered: " + std::to_string(lastFrame.bvhNodesVisited) + " / " + std::to_string(lastFrame.bvhNodesDrawnFromCache) + " / " + std::to_string(lastFrame.bvhNodesRerendered));
+    lines.emplace_back("Components drawn / unsorted / occluded: " + std::to_string(lastFrame.componentsDrawn) + " / " + std::to_string(lastFrame.unsortedComponentsDrawn) + " / " + std::to_string(lastFrame.componentsOccluded));
+    lines.emplace_back("Mesh triangles: " + std::to_string(lastFrame.meshTrianglesSubmitted));
+    lines.emplace_back("Save layers: " + std::to_string(lastFrame.saveLayerCount));
+    std::string mipmapLevelsLine = "Image mipmap levels:";
+    for(auto& [level, count] : lastFrame.imageMipmapLevelDraws)
+        mipmapLevelsLine += " " + std::to_string(level) + "x" + std::to_string(count);
+    lines.emplace_back(mipmapLevelsLine);
+
+    SkFontMetrics metrics;
+    font.getMetrics(&metrics);
+    float lineHeight = -metrics.fAscent + metrics.fDescent;
+    float width = 0.0f;
+    for(auto& line : lines)
+        width = std::max(width, font.measureText(line.c_str(), line.size(), SkTextEncoding::kUTF8));
+
+    const float PADDING = 5.0f;
+    SkPaint backPaint(SkColor4f{0.0f, 0.0f, 0.0f, 0.7f});
+    canvas->drawRect(SkRect::MakeXYWH(0.0f, 0.0f, width + PADDING * 2.0f, lineHeight * lines.size() + PADDING * 2.0f), backPaint);
+    SkPaint textPaint(SkColor4f{1.0f, 1.0f, 1.0f, 1.0f});
+    for(size_t i = 0; i < lines.size(); i++)
+        canvas->drawSimpleText(lines[i].c_str(), lines[i].size(), SkTextEncoding::kUTF8, PADDING, PADDING + lineHeight * i - metrics.fAscent, font, textPaint);
+}
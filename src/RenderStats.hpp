@@ -0,0 +1,60 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <include/core/SkCanvas.h>
+#include <include/core/SkFont.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <filesystem>
+#include <map>
+
+// Counts what went into drawing a frame, so that the content making a canvas slow can be found. Counters are only updated from
+// the main thread. The last finished frame is shown in the render stats overlay, and can be dumped as JSON from the debug settings
+class RenderStats {
+    public:
+        static bool SHOW_OVERLAY;
+
+        struct Frame {
+            uint64_t bvhNodesVisited = 0;
+            uint64_t bvhNodesDrawnFromCache = 0;
+            uint64_t bvhNodesRerendered = 0;
+            uint64_t componentsDrawn = 0;
+            uint64_t unsortedComponentsDrawn = 0;
+            uint64_t componentsOccluded = 0;
+            uint64_t meshTrianglesSubmitted = 0;
+            uint64_t saveLayerCount = 0;
+            std::map<unsigned, uint64_t> imageMipmapLevelDraws; // Images drawn with each mipmap level, where level 0 is full resolution
+            std::chrono::steady_clock::duration updateTime{0};
+            std::chrono::steady_clock::duration predrawTime{0}; // Included in drawTime
+            std::chrono::steady_clock::duration drawTime{0};
+            std::chrono::steady_clock::duration flushTime{0};
+        };
+
+        static Frame& current();
+        static const Frame& last();
+        static void end_frame();
+
+        static nlohmann::json frame_to_json(const Frame& frame);
+        // Writes the last frame to the log and to filePath
+        static void dump_last_frame(const std::filesystem::path& filePath);
+        static void draw_overlay(SkCanvas* canvas, const SkFont& font);
+    private:
+        static Frame currentFrame;
+        static Frame lastFrame;
+};
@@ -17,6 +17,7 @@
  */
 
 #include "ImageResourceDisplay.hpp"
+#include "ResourceLoadPool.hpp"
 #include <chrono>
 #include <include/codec/SkPngDecoder.h>
 #include <include/codec/SkJpegDecoder.h>
@@ -28,6 +29,7 @@
 #include <include/codec/SkWebpDecoder.h>
 #include <include/core/SkCanvas.h>
 #include "../MainProgram.hpp"
+#include "../RenderStats.hpp"
 #include <Helpers/Logger.hpp>
 #include <include/core/SkImageInfo.h>
 #include <include/core/SkSamplingOptions.h>
@@ -53,13 +55,6 @@ std::array<const SkCodecs::Decoder, 7> decoders2 = {
 };
 
 std::unordered_map<std::shared_ptr<std::string>, sk_sp<SkImage>> ImageResourceDisplay::screenshotCache;
-std::atomic<int> ImageResourceDisplay::imageLoadThreadCount = 0;
-
-#ifdef __EMSCRIPTEN__
-    int ImageResourceDisplay::IMAGE_LOAD_THREAD_COUNT_MAX = 1;
-#else
-    int ImageResourceDisplay::IMAGE_LOAD_THREAD_COUNT_MAX = 4;
-#endif
 
 bool ImageResourceDisplay::update_draw() const {
     return mustUpdateDraw;
@@ -75,6 +70,7 @@ void ImageResourceDisplay::update(World& w) {
             mipmapLevelsStatus[mipmapLevel] = MipmapLevelStatus::UNALLOCATED;
             for(auto& frame : frames)
                 frame.mipmapLevels[mipmapLevel] = nullptr;
+            release_cache_bytes(get_mipmap_level_bytes(mipmapLevel));
         }
     }
 
@@ -126,13 +122,13 @@ sk_sp<SkImage> ImageResourceDisplay::load_frame_with_codec(const std::unique_ptr
 
 void ImageResourceDisplay::camera_view_update(const CoordSpaceHelper& compCoords, const SCollision::AABB<WorldScalar>& compAABB, const DrawData& drawData, const SkRect& imRect) {
     if(!smallestMipmapLevelLoaded)
-        attempt_load_mipmap_in_separate_thread(get_smallest_mipmap_level());
+        request_load_mipmap(get_smallest_mipmap_level(), get_load_priority(compAABB, drawData, true));
     else {
         if(SCollision::collide(compAABB, drawData.cam.viewingAreaGenerousCollider)) {
             unsigned mipmapLevel = get_exact_mipmap_level_for_image_component(drawData, compCoords, imRect);
             if(mipmapLevel != get_smallest_mipmap_level()) {
                 if(mipmapLevelsStatus[mipmapLevel] == MipmapLevelStatus::UNALLOCATED) {
-                    attempt_load_mipmap_in_separate_thread(mipmapLevel);
+                    request_load_mipmap(mipmapLevel, get_load_priority(compAABB, drawData, false));
                     unsigned nextBestMipmapLevel = get_best_allocated_mipmap_level(mipmapLevel);
                     if(nextBestMipmapLevel != get_smallest_mipmap_level())
                         mipmapLevelsStatus[nextBestMipmapLevel] = MipmapLevelStatus::ALLOCATED_JUST_SET;
@@ -174,44 +170,54 @@ bool ImageResourceDisplay::load(ResourceManager& rMan, const std::string& fileNa
             imageInfo = imageInfo.makeDimensions(SkISize(imageInfo.height(), imageInfo.width()));
         }
         codec = nullptr;
-        attempt_load_mipmap_in_separate_thread(get_smallest_mipmap_level());
         return true;
     }
     return false;
 }
 
-void ImageResourceDisplay::attempt_load_mipmap_in_separate_thread(unsigned mipmapLevel) {
-    if(imageLoadThreadCount >= IMAGE_LOAD_THREAD_COUNT_MAX)
+void ImageResourceDisplay::request_load_mipmap(unsigned mipmapLevel, float priority) {
+    if(decodeFailed)
         return;
-    if(!loadThread) {
-        shutdownLoadThread = false;
-        imageLoadThreadCount++;
-        loadThread = std::make_unique<std::thread>(&ImageResourceDisplay::load_thread_func, this, mipmapLevel);
-    }
-    else if(shutdownLoadThread) {
-        loadThread->join();
-        shutdownLoadThread = false;
-        imageLoadThreadCount++;
-        loadThread = std::make_unique<std::thread>(&ImageResourceDisplay::load_thread_func, this, mipmapLevel);
-    }
+    // The smallest mipmap level is always kept, so only the other levels count towards the shared cache budget. When the budget
+    // is used up, the image keeps being drawn with the best level that is already allocated
+    if(mipmapLevel != get_smallest_mipmap_level() && !cache_bytes_fit(get_mipmap_level_bytes(mipmapLevel)))
+        return;
+    ResourceLoadPool::get().request(this, priority, [this, mipmapLevel] {
+        load_mipmap(mipmapLevel);
+    });
 }
 
-void ImageResourceDisplay::load_thread_func(unsigned mipmapLevel) {
+void ImageResourceDisplay::load_mipmap(unsigned mipmapLevel) {
+    // Runs on a ResourceLoadPool thread. The budget was only checked when requested, other jobs might have used it up since
+    bool isSmallestMipmapLevel = mipmapLevel == get_smallest_mipmap_level();
+    if(!isSmallestMipmapLevel && !reserve_cache_bytes(get_mipmap_level_bytes(mipmapLevel)))
+        return;
     auto codec = SkCodec::MakeFromData(SkData::MakeWithoutCopy(this->fileData->c_str(), this->fileData->size()), decoders2);
-    for(size_t i = 0; i < frames.size(); i++) {
-        if(shutdownLoadThread)
-            return;
-        auto& frame = frames[i];
-        auto& mipmapImage = (mipmapLevel == get_smallest_mipmap_level()) ? frame.smallestMipmapLevel : frame.mipmapLevels[mipmapLevel];
-        mipmapImage = load_frame_with_codec(codec, mipmapLevel, i);
+    try {
+        for(size_t i = 0; i < frames.size(); i++) {
+            if(cancelLoad) {
+                if(!isSmallestMipmapLevel)
+                    release_cache_bytes(get_mipmap_level_bytes(mipmapLevel));
+                return;
+            }
+            auto& frame = frames[i];
+            auto& mipmapImage = isSmallestMipmapLevel ? frame.smallestMipmapLevel : frame.mipmapLevels[mipmapLevel];
+            mipmapImage = load_frame_with_codec(codec, mipmapLevel, i);
+        }
     }
-    if(mipmapLevel == get_smallest_mipmap_level())
+    catch(const std::exception& e) {
+        // The pool threads are shared, so a bad image can't be allowed to take one down. The image stays a placeholder
+        Logger::get().log(Logger::LogType::INFO, std::string("[ImageResourceDisplay::load_mipmap] ") + e.what());
+        if(!isSmallestMipmapLevel)
+            release_cache_bytes(get_mipmap_level_bytes(mipmapLevel));
+        decodeFailed = true;
+        return;
+    }
+    if(isSmallestMipmapLevel)
         smallestMipmapLevelLoaded = true;
     else
         mipmapLevelsStatus[mipmapLevel] = MipmapLevelStatus::ALLOCATED_JUST_SET;
     mustUpdateDrawLoadThread = true;
-    imageLoadThreadCount--;
-    shutdownLoadThread = true;
 }
 
 void ImageResourceDisplay::draw(SkCanvas* canvas, const DrawData& drawData, const SkRect& imRect) {
@@ -225,6 +231,7 @@ void ImageResourceDisplay::draw(SkCanvas* canvas, const DrawData& drawData, cons
         unsigned mipmapLevel = get_exact_mipmap_level_for_dimensions({imRectPixelSize.width(), imRectPixelSize.height()});
         auto& frame = frames[frameIndex];
         unsigned closestMipmapLevel = get_best_allocated_mipmap_level(mipmapLevel);
+        RenderStats::current().imageMipmapLevelDraws[closestMipmapLevel]++;
         if(drawData.takingScreenshot) {
             if(closestMipmapLevel == mipmapLevel) {
                 if(closestMipmapLevel == get_smallest_mipmap_level())
@@ -303,6 +310,11 @@ Vector2i ImageResourceDisplay::get_mipmap_level_image_dimensions(unsigned mipmap
     return {imageInfo.width() / divideResolutionBy, imageInfo.height() / divideResolutionBy};
 }
 
+size_t ImageResourceDisplay::get_mipmap_level_bytes(unsigned mipmapLevel) const {
+    Vector2i dim = get_mipmap_level_image_dimensions(mipmapLevel);
+    return static_cast<size_t>(dim.x()) * dim.y() * imageInfo.bytesPerPixel() * frames.size();
+}
+
 Vector2f ImageResourceDisplay::get_dimensions() const {
     return {imageInfo.width(), imageInfo.height()};
 }
@@ -316,22 +328,25 @@ ResourceDisplay::Type ImageResourceDisplay::get_type() const {
 }
 
 void ImageResourceDisplay::clear_cache() {
-    if(loadThread) {
-        shutdownLoadThread = true;
-        loadThread->join();
-        loadThread = nullptr;
-    }
+    cancelLoad = true;
+    ResourceLoadPool::get().cancel_and_wait(this);
+    cancelLoad = false;
     for(auto& frame : frames) {
         for(auto& mipmap : frame.mipmapLevels)
             mipmap = nullptr;
     }
-    for(auto& mipmapStatus : mipmapLevelsStatus)
-        mipmapStatus = MipmapLevelStatus::UNALLOCATED;
+    for(size_t mipmapLevel = 0; mipmapLevel < mipmapLevelsStatus.size(); mipmapLevel++) {
+        if(mipmapLevelsStatus[mipmapLevel] != MipmapLevelStatus::UNALLOCATED)
+            release_cache_bytes(get_mipmap_level_bytes(mipmapLevel));
+        mipmapLevelsStatus[mipmapLevel] = MipmapLevelStatus::UNALLOCATED;
+    }
+}
+
+bool ImageResourceDisplay::is_opaque() const {
+    // A placeholder rectangle is drawn until the smallest mipmap level is loaded
+    return smallestMipmapLevelLoaded && imageInfo.isOpaque();
 }
 
 ImageResourceDisplay::~ImageResourceDisplay() {
-    if(loadThread) {
-        shutdownLoadThread = true;
-        loadThread->join();
-    }
+    clear_cache();
 }
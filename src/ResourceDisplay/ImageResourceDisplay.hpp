@@ -20,7 +20,6 @@
 #include "ResourceDisplay.hpp"
 #include <include/core/SkImage.h>
 #include <vector>
-#include <thread>
 #include <include/codec/SkCodec.h>
 #include <queue>
 
@@ -35,10 +34,9 @@ class ImageResourceDisplay : public ResourceDisplay {
         virtual Type get_type() const override;
         virtual void camera_view_update(const CoordSpaceHelper& compCoords, const SCollision::AABB<WorldScalar>& compAABB, const DrawData& drawData, const SkRect& imRect) override;
         virtual void clear_cache() override;
+        virtual bool is_opaque() const override;
         virtual ~ImageResourceDisplay() override;
 
-        static int IMAGE_LOAD_THREAD_COUNT_MAX;
-
     private:
         static constexpr int SMALLEST_MIPMAP_RESOLUTION = 128;
         
@@ -52,8 +50,6 @@ class ImageResourceDisplay : public ResourceDisplay {
 
         static std::unordered_map<std::shared_ptr<std::string>, sk_sp<SkImage>> screenshotCache;
 
-        static std::atomic<int> imageLoadThreadCount;
-
         std::vector<FrameData> frames;
 
         enum class MipmapLevelStatus {
@@ -72,8 +68,8 @@ class ImageResourceDisplay : public ResourceDisplay {
         unsigned frameIndex = 0;
         bool mustUpdateDraw = false;
 
-        std::unique_ptr<std::thread> loadThread;
-        std::atomic<bool> shutdownLoadThread = false;
+        std::atomic<bool> cancelLoad = false; // Stops decoding the frames of a running load job
+        std::atomic<bool> decodeFailed = false;
         std::atomic<bool> mustUpdateDrawLoadThread = false;
 
         unsigned get_exact_mipmap_level_for_image_component(const DrawData& drawData, const CoordSpaceHelper& compCoords, const SkRect& imRect);
@@ -81,8 +77,9 @@ class ImageResourceDisplay : public ResourceDisplay {
         unsigned get_best_allocated_mipmap_level(unsigned mipmapLevel);
         unsigned get_smallest_mipmap_level() const;
         Vector2i get_mipmap_level_image_dimensions(unsigned mipmapLevel) const;
+        size_t get_mipmap_level_bytes(unsigned mipmapLevel) const;
         unsigned calculate_smallest_mipmap_level();
-        void load_thread_func(unsigned mipmapLevel);
-        void attempt_load_mipmap_in_separate_thread(unsigned mipmapLevel);
+        void load_mipmap(unsigned mipmapLevel);
+        void request_load_mipmap(unsigned mipmapLevel, float priority);
         sk_sp<SkImage> load_frame_with_codec(const std::unique_ptr<SkCodec>& codec, unsigned mipmapLevel, unsigned frameIndexToLoad);
 };
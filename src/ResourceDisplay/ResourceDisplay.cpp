@@ -17,6 +17,17 @@
  */
 
 #include "ResourceDisplay.hpp"
+#include "../DrawData.hpp"
+#include <cmath>
+
+std::atomic<size_t> ResourceDisplay::cacheBytesResident = 0;
+size_t ResourceDisplay::RESOURCE_CACHE_MEMORY_BUDGET_MB = 1024;
+
+#ifdef __EMSCRIPTEN__
+    int ResourceDisplay::IMAGE_LOAD_THREAD_COUNT_MAX = 1;
+#else
+    int ResourceDisplay::IMAGE_LOAD_THREAD_COUNT_MAX = 4;
+#endif
 
 void ResourceDisplay::camera_view_update(const CoordSpaceHelper& compCoords, const SCollision::AABB<WorldScalar>& compAABB, const DrawData& drawData, const SkRect& imRect) {
 }
@@ -24,4 +35,55 @@ void ResourceDisplay::camera_view_update(const CoordSpaceHelper& compCoords, con
 void ResourceDisplay::clear_cache() {
 }
 
+bool ResourceDisplay::is_opaque() const {
+    return false;
+}
+
+size_t ResourceDisplay::get_cache_bytes_resident() {
+    return cacheBytesResident;
+}
+
+bool ResourceDisplay::reserve_cache_bytes(size_t bytes) {
+    // Called from the main thread and the load threads, so the check and the add have to be done together
+    size_t budgetBytes = RESOURCE_CACHE_MEMORY_BUDGET_MB * 1024 * 1024;
+    size_t bytesResident = cacheBytesResident;
+    do {
+        if(bytesResident + bytes > budgetBytes)
+            return false;
+    } while(!cacheBytesResident.compare_exchange_weak(bytesResident, bytesResident + bytes));
+    return true;
+}
+
+void ResourceDisplay::release_cache_bytes(size_t bytes) {
+    cacheBytesResident -= bytes;
+}
+
+bool ResourceDisplay::cache_bytes_fit(size_t bytes) {
+    return cacheBytesResident + bytes <= RESOURCE_CACHE_MEMORY_BUDGET_MB * 1024 * 1024;
+}
+
+float ResourceDisplay::get_load_priority(const SCollision::AABB<WorldScalar>& compAABB, const DrawData& drawData, bool replacesPlaceholder) {
+    std::array<Vector2f, 4> corners = drawData.cam.c.aabb_corners_to_space(compAABB);
+    SCollision::AABB<float> screenAABB(corners[0], corners[0]);
+    for(const Vector2f& corner : corners)
+        screenAABB.include_point_in_bounds(corner);
+
+    const Vector2f& viewingArea = drawData.cam.viewingArea;
+    float priority;
+    Vector2f overlapMin = screenAABB.min.cwiseMax(Vector2f{0.0f, 0.0f});
+    Vector2f overlapMax = screenAABB.max.cwiseMin(viewingArea);
+    if(overlapMin.x() < overlapMax.x() && overlapMin.y() < overlapMax.y()) {
+        Vector2f overlapSize = overlapMax - overlapMin;
+        priority = 1.0f + (overlapSize.x() * overlapSize.y()) / (viewingArea.x() * viewingArea.y());
+    }
+    else {
+        Vector2f gap = (-screenAABB.max).cwiseMax(screenAABB.min - viewingArea).cwiseMax(Vector2f{0.0f, 0.0f});
+        priority = 1.0f / (1.0f + gap.norm() / viewingArea.norm());
+    }
+    if(!std::isfinite(priority)) // Components very far from the camera can go past the float range in screen space
+        priority = 0.0f;
+
+    return replacesPlaceholder ? priority + 2.0f : priority;
+}
+
 ResourceDisplay::~ResourceDisplay() {}
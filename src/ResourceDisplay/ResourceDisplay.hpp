@@ -23,6 +23,7 @@
 #include "../SharedTypes.hpp"
 #include <Helpers/SCollision.hpp>
 #include "../CoordSpaceHelper.hpp"
+#include <atomic>
 
 using namespace Eigen;
 
@@ -46,5 +47,21 @@ class ResourceDisplay {
         virtual Type get_type() const = 0;
         virtual void camera_view_update(const CoordSpaceHelper& compCoords, const SCollision::AABB<WorldScalar>& compAABB, const DrawData& drawData, const SkRect& imRect);
         virtual void clear_cache();
+        virtual bool is_opaque() const; // Whether draw currently covers imRect completely with opaque pixels
         virtual ~ResourceDisplay();
+
+        static int IMAGE_LOAD_THREAD_COUNT_MAX; // Threads in ResourceLoadPool, shared by image decoding and SVG rasterizing
+        static size_t RESOURCE_CACHE_MEMORY_BUDGET_MB; // Shared by the image mipmap levels and SVG rasterizations of every resource
+        static size_t get_cache_bytes_resident();
+    protected:
+        // Returns false, without reserving anything, if the bytes don't fit in the budget
+        static bool reserve_cache_bytes(size_t bytes);
+        static void release_cache_bytes(size_t bytes);
+        static bool cache_bytes_fit(size_t bytes);
+
+        // Priority of a ResourceLoadPool job for a component. Components on screen come first, ordered by how much of the screen they
+        // cover, then the ones off screen, ordered by how close they are to it. Jobs that replace the placeholder come before all others
+        static float get_load_priority(const SCollision::AABB<WorldScalar>& compAABB, const DrawData& drawData, bool replacesPlaceholder);
+    private:
+        static std::atomic<size_t> cacheBytesResident;
 };
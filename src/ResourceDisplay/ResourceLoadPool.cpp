@@ -0,0 +1,99 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ResourceLoadPool.hpp"
+#include "ResourceDisplay.hpp"
+#include <algorithm>
+
+ResourceLoadPool ResourceLoadPool::global;
+
+ResourceLoadPool& ResourceLoadPool::get() {
+    return global;
+}
+
+void ResourceLoadPool::request(const void* owner, float priority, std::function<void()> job) {
+    std::scoped_lock lock(poolMutex);
+    if(runningJobOwners.contains(owner))
+        return;
+    auto it = queuedJobs.find(owner);
+    if(it == queuedJobs.end())
+        queuedJobs.emplace(owner, Job{priority, std::move(job), true});
+    else if(!it->second.requestedThisFrame || priority > it->second.priority)
+        it->second = Job{priority, std::move(job), true};
+    else
+        return;
+    jobQueuedCV.notify_all(); // notify_one could wake a worker past activeWorkerCount, which would go back to waiting
+}
+
+void ResourceLoadPool::cancel_and_wait(const void* owner) {
+    std::unique_lock lock(poolMutex);
+    queuedJobs.erase(owner);
+    jobFinishedCV.wait(lock, [&] { return !runningJobOwners.contains(owner); });
+}
+
+void ResourceLoadPool::end_frame() {
+    std::scoped_lock lock(poolMutex);
+    std::erase_if(queuedJobs, [](auto& p) {
+        return !p.second.requestedThisFrame;
+    });
+    for(auto& [owner, job] : queuedJobs)
+        job.requestedThisFrame = false;
+
+    size_t newActiveWorkerCount = std::max(ResourceDisplay::IMAGE_LOAD_THREAD_COUNT_MAX, 1);
+    while(workers.size() < newActiveWorkerCount)
+        workers.emplace_back(&ResourceLoadPool::worker_func, this, workers.size());
+    if(newActiveWorkerCount != activeWorkerCount) {
+        activeWorkerCount = newActiveWorkerCount;
+        jobQueuedCV.notify_all();
+    }
+}
+
+void ResourceLoadPool::worker_func(size_t workerIndex) {
+    std::unique_lock lock(poolMutex);
+    for(;;) {
+        jobQueuedCV.wait(lock, [&] { return shutdown || (!queuedJobs.empty() && workerIndex < activeWorkerCount); });
+        if(shutdown)
+            return;
+        // A linear search is fine here, there's one job per display at most, and priorities change every frame anyway
+        auto it = std::max_element(queuedJobs.begin(), queuedJobs.end(), [](auto& a, auto& b) {
+            return a.second.priority < b.second.priority;
+        });
+        const void* owner = it->first;
+        std::function<void()> func = std::move(it->second.func);
+        queuedJobs.erase(it);
+        runningJobOwners.emplace(owner);
+
+        lock.unlock();
+        func();
+        lock.lock();
+
+        runningJobOwners.erase(owner);
+        jobFinishedCV.notify_all();
+    }
+}
+
+ResourceLoadPool::~ResourceLoadPool() {
+    {
+        std::scoped_lock lock(poolMutex);
+        shutdown = true;
+        queuedJobs.clear();
+    }
+    jobQueuedCV.notify_all();
+    for(auto& worker : workers)
+        worker.join();
+}
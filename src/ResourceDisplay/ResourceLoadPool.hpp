@@ -0,0 +1,62 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Threads shared by every resource display to decode images and rasterize SVGs. Each display has at most one queued job, which
+// has to be requested again every frame from camera_view_update to stay queued, so jobs for resources that scrolled far away or
+// were closed are dropped. The highest priority job runs first. Priorities are recalculated each frame, so moving the camera
+// reorders the queue
+class ResourceLoadPool {
+    public:
+        static ResourceLoadPool& get();
+        // Queues the job, or replaces the owner's queued job. When the owner was already requested this frame, the job with the
+        // higher priority is kept. Does nothing while a job of the owner is running
+        void request(const void* owner, float priority, std::function<void()> job);
+        // Removes the owner's queued job and waits until its running job is done
+        void cancel_and_wait(const void* owner);
+        // Called once a frame, after the displays were requested. Drops the jobs that weren't requested since the last call
+        void end_frame();
+        ~ResourceLoadPool();
+    private:
+        struct Job {
+            float priority;
+            std::function<void()> func;
+            bool requestedThisFrame;
+        };
+
+        static ResourceLoadPool global;
+
+        void worker_func(size_t workerIndex);
+
+        std::mutex poolMutex;
+        std::condition_variable jobQueuedCV;
+        std::condition_variable jobFinishedCV;
+        std::unordered_map<const void*, Job> queuedJobs;
+        std::unordered_set<const void*> runningJobOwners;
+        std::vector<std::thread> workers;
+        size_t activeWorkerCount = 0; // Workers past this index stay idle, so the thread count setting can be lowered while running
+        bool shutdown = false;
+};
@@ -17,20 +17,41 @@
  */
 
 #include "SvgResourceDisplay.hpp"
+#include "ResourceLoadPool.hpp"
 #include "../MainProgram.hpp"
 #include <Helpers/Logger.hpp>
 #include <include/core/SkStream.h>
+#include <include/core/SkSurface.h>
 #include <modules/svg/include/SkSVGRenderContext.h>
+#include <bit>
+#include <cmath>
+#include <limits>
 
 bool SvgResourceDisplay::update_draw() const {
     return mustUpdateDraw;
 }
 
 void SvgResourceDisplay::update(World& w) {
-    mustUpdateDraw = false;
+    for(size_t mipmapLevel = 0; mipmapLevel < mipmapLevelsStatus.size(); mipmapLevel++) {
+        if(mipmapLevelsStatus[mipmapLevel] == MipmapLevelStatus::ALLOCATED_JUST_SET)
+            mipmapLevelsStatus[mipmapLevel] = MipmapLevelStatus::ALLOCATED_WILL_REMOVE;
+        else if(mipmapLevelsStatus[mipmapLevel] == MipmapLevelStatus::ALLOCATED_WILL_REMOVE) {
+            mipmapLevelsStatus[mipmapLevel] = MipmapLevelStatus::UNALLOCATED;
+            mipmapLevels[mipmapLevel] = nullptr;
+            release_cache_bytes(get_mipmap_level_bytes(mipmapLevel));
+        }
+    }
+
+    if(mustUpdateDrawRasterThread) {
+        mustUpdateDraw = true;
+        mustUpdateDrawRasterThread = false;
+    }
+    else
+        mustUpdateDraw = false;
 }
 
 bool SvgResourceDisplay::load(ResourceManager& rMan, const std::string& fileName, const std::shared_ptr<std::string>& fileData) {
+    this->fileData = fileData;
     SkMemoryStream strm(fileData->c_str(), fileData->size());
     svgDom = SkSVGDOM::Builder().make(strm);
 
@@ -49,10 +70,100 @@ bool SvgResourceDisplay::load(ResourceManager& rMan, const std::string& fileName
     if(svgRootSize.width() == 0 || svgRootSize.height() == 0)
         return false;
 
+    unsigned mipmapLevelCount = std::bit_width<unsigned>(LARGEST_MIPMAP_RESOLUTION / SMALLEST_MIPMAP_RESOLUTION) - 1;
+    mipmapLevels.resize(mipmapLevelCount);
+    mipmapLevelsStatus = std::vector<std::atomic<MipmapLevelStatus>>(mipmapLevelCount);
+    for(auto& mipmapLevelStatus : mipmapLevelsStatus)
+        mipmapLevelStatus = MipmapLevelStatus::UNALLOCATED;
+
     return true;
 }
 
+void SvgResourceDisplay::camera_view_update(const CoordSpaceHelper& compCoords, const SCollision::AABB<WorldScalar>& compAABB, const DrawData& drawData, const SkRect& imRect) {
+    if(!smallestMipmapLevelLoaded)
+        request_rasterize_mipmap(get_smallest_mipmap_level(), get_load_priority(compAABB, drawData, false));
+    else if(SCollision::collide(compAABB, drawData.cam.viewingAreaGenerousCollider)) {
+        Vector2f imRectPixelSize{drawData.cam.c.scalar_to_space(compCoords.scalar_from_space(imRect.width())), drawData.cam.c.scalar_to_space(compCoords.scalar_from_space(imRect.height()))};
+        std::optional<unsigned> mipmapLevel = get_exact_mipmap_level_for_dimensions(imRectPixelSize);
+        if(mipmapLevel.has_value() && mipmapLevel.value() != get_smallest_mipmap_level()) {
+            if(mipmapLevelsStatus[mipmapLevel.value()] == MipmapLevelStatus::UNALLOCATED) {
+                request_rasterize_mipmap(mipmapLevel.value(), get_load_priority(compAABB, drawData, false));
+                unsigned nextBestMipmapLevel = get_best_allocated_mipmap_level(mipmapLevel.value());
+                if(nextBestMipmapLevel != get_smallest_mipmap_level())
+                    mipmapLevelsStatus[nextBestMipmapLevel] = MipmapLevelStatus::ALLOCATED_JUST_SET;
+            }
+            else
+                mipmapLevelsStatus[mipmapLevel.value()] = MipmapLevelStatus::ALLOCATED_JUST_SET;
+        }
+    }
+}
+
+void SvgResourceDisplay::request_rasterize_mipmap(unsigned mipmapLevel, float priority) {
+    // Same budget as the image mipmap levels. The smallest mipmap level is always kept, so it isn't counted
+    if(mipmapLevel != get_smallest_mipmap_level() && !cache_bytes_fit(get_mipmap_level_bytes(mipmapLevel)))
+        return;
+    ResourceLoadPool::get().request(this, priority, [this, mipmapLevel] {
+        rasterize_mipmap(mipmapLevel);
+    });
+}
+
+void SvgResourceDisplay::rasterize_mipmap(unsigned mipmapLevel) {
+    bool isSmallestMipmapLevel = mipmapLevel == get_smallest_mipmap_level();
+    if(!isSmallestMipmapLevel && !reserve_cache_bytes(get_mipmap_level_bytes(mipmapLevel)))
+        return;
+
+    // SkSVGDOM can't be rendered from two threads at once, and the main thread still renders svgDom when the SVG is drawn bigger
+    // than the largest mipmap level, so this builds its own
+    sk_sp<SkImage> rasterized;
+    SkMemoryStream strm(fileData->c_str(), fileData->size());
+    sk_sp<SkSVGDOM> threadSvgDom = SkSVGDOM::Builder().make(strm);
+    if(threadSvgDom && !cancelRaster) {
+        threadSvgDom->setContainerSize(svgRootSize);
+        SkISize mipmapLevelDim = get_mipmap_level_image_dimensions(mipmapLevel);
+        sk_sp<SkSurface> surface = SkSurfaces::Raster(SkImageInfo::MakeN32Premul(mipmapLevelDim));
+        if(surface) {
+            surface->getCanvas()->scale(mipmapLevelDim.width() / svgRootSize.width(), mipmapLevelDim.height() / svgRootSize.height());
+            threadSvgDom->render(surface->getCanvas());
+            rasterized = surface->makeImageSnapshot();
+        }
+    }
+
+    if(!rasterized || cancelRaster) {
+        if(!cancelRaster)
+            Logger::get().log(Logger::LogType::INFO, "Could not rasterize SVG mipmap level " + std::to_string(mipmapLevel));
+        if(!isSmallestMipmapLevel)
+            release_cache_bytes(get_mipmap_level_bytes(mipmapLevel));
+        return;
+    }
+
+    if(isSmallestMipmapLevel) {
+        smallestMipmapLevel = rasterized->withDefaultMipmaps();
+        smallestMipmapLevelLoaded = true;
+    }
+    else {
+        mipmapLevels[mipmapLevel] = rasterized;
+        mipmapLevelsStatus[mipmapLevel] = MipmapLevelStatus::ALLOCATED_JUST_SET;
+    }
+    mustUpdateDrawRasterThread = true;
+}
+
 void SvgResourceDisplay::draw(SkCanvas* canvas, const DrawData& drawData, const SkRect& imRect) {
+    // Screenshots and SVG exports always render the DOM, so they keep full quality
+    if(smallestMipmapLevelLoaded && !drawData.takingScreenshot && !drawData.isSVGRender) {
+        SkRect imRectPixelSize = canvas->getLocalToDeviceAs3x3().mapRect(imRect);
+        std::optional<unsigned> mipmapLevel = get_exact_mipmap_level_for_dimensions({imRectPixelSize.width(), imRectPixelSize.height()});
+        if(mipmapLevel.has_value()) {
+            unsigned closestMipmapLevel = get_best_allocated_mipmap_level(mipmapLevel.value());
+            SkPaint p;
+            p.setAntiAlias(drawData.skiaAA);
+            if(closestMipmapLevel == get_smallest_mipmap_level())
+                canvas->drawImageRect(smallestMipmapLevel, imRect, {SkFilterMode::kLinear, SkMipmapMode::kLinear}, &p);
+            else
+                canvas->drawImageRect(mipmapLevels[closestMipmapLevel], imRect, {SkFilterMode::kLinear, SkMipmapMode::kNone}, &p);
+            return;
+        }
+    }
+
     canvas->save();
     canvas->clipRect(imRect);
     canvas->translate(imRect.x(), imRect.y());
@@ -72,3 +183,58 @@ float SvgResourceDisplay::get_dimension_scale() const {
 ResourceDisplay::Type SvgResourceDisplay::get_type() const {
     return ResourceDisplay::Type::SVG;
 }
+
+std::optional<unsigned> SvgResourceDisplay::get_exact_mipmap_level_for_dimensions(const Vector2f& pixelDim) const {
+    SkISize largestDim = get_mipmap_level_image_dimensions(0);
+    float scaleFromLargest = std::max(pixelDim.x() / largestDim.width(), pixelDim.y() / largestDim.height());
+    if(!(scaleFromLargest <= 1.0f))
+        return std::nullopt;
+    if(scaleFromLargest <= 0.0f)
+        return get_smallest_mipmap_level();
+    return static_cast<unsigned>(std::min(std::floor(std::log2(1.0f / scaleFromLargest)), static_cast<float>(get_smallest_mipmap_level())));
+}
+
+unsigned SvgResourceDisplay::get_best_allocated_mipmap_level(unsigned mipmapLevel) const {
+    if(mipmapLevel == get_smallest_mipmap_level())
+        return mipmapLevel;
+    constexpr static unsigned NUMERIC_UNSIGNED_MAX = std::numeric_limits<unsigned>::max();
+    for(unsigned i = mipmapLevel; i != NUMERIC_UNSIGNED_MAX; i--) {
+        if(mipmapLevelsStatus[i] != MipmapLevelStatus::UNALLOCATED)
+            return i;
+    }
+    for(unsigned i = mipmapLevel; i < get_smallest_mipmap_level(); i++) {
+        if(mipmapLevelsStatus[i] != MipmapLevelStatus::UNALLOCATED)
+            return i;
+    }
+    return get_smallest_mipmap_level();
+}
+
+unsigned SvgResourceDisplay::get_smallest_mipmap_level() const {
+    return mipmapLevelsStatus.size();
+}
+
+SkISize SvgResourceDisplay::get_mipmap_level_image_dimensions(unsigned mipmapLevel) const {
+    float scale = static_cast<float>(LARGEST_MIPMAP_RESOLUTION >> mipmapLevel) / std::max(svgRootSize.width(), svgRootSize.height());
+    return {std::max(static_cast<int>(std::round(svgRootSize.width() * scale)), 1), std::max(static_cast<int>(std::round(svgRootSize.height() * scale)), 1)};
+}
+
+size_t SvgResourceDisplay::get_mipmap_level_bytes(unsigned mipmapLevel) const {
+    SkISize dim = get_mipmap_level_image_dimensions(mipmapLevel);
+    return static_cast<size_t>(dim.width()) * dim.height() * 4;
+}
+
+void SvgResourceDisplay::clear_cache() {
+    cancelRaster = true;
+    ResourceLoadPool::get().cancel_and_wait(this);
+    cancelRaster = false;
+    for(size_t mipmapLevel = 0; mipmapLevel < mipmapLevelsStatus.size(); mipmapLevel++) {
+        if(mipmapLevelsStatus[mipmapLevel] != MipmapLevelStatus::UNALLOCATED)
+            release_cache_bytes(get_mipmap_level_bytes(mipmapLevel));
+        mipmapLevelsStatus[mipmapLevel] = MipmapLevelStatus::UNALLOCATED;
+        mipmapLevels[mipmapLevel] = nullptr;
+    }
+}
+
+SvgResourceDisplay::~SvgResourceDisplay() {
+    clear_cache();
+}
@@ -20,6 +20,7 @@
 #include "ResourceDisplay.hpp"
 #include <include/core/SkImage.h>
 #include <vector>
+#include <optional>
 #include <modules/svg/include/SkSVGDOM.h>
 
 class SvgResourceDisplay : public ResourceDisplay {
@@ -31,8 +32,39 @@ class SvgResourceDisplay : public ResourceDisplay {
         virtual Vector2f get_dimensions() const override;
         virtual float get_dimension_scale() const override;
         virtual Type get_type() const override;
+        virtual void camera_view_update(const CoordSpaceHelper& compCoords, const SCollision::AABB<WorldScalar>& compAABB, const DrawData& drawData, const SkRect& imRect) override;
+        virtual void clear_cache() override;
+        virtual ~SvgResourceDisplay() override;
     private:
+        // The SVG is rasterized into power of two mipmap levels, where level 0 has its bigger dimension at LARGEST_MIPMAP_RESOLUTION
+        // pixels. When the SVG is drawn bigger than that, the DOM is rendered directly instead
+        static constexpr int LARGEST_MIPMAP_RESOLUTION = 2048;
+        static constexpr int SMALLEST_MIPMAP_RESOLUTION = 128;
+
+        enum class MipmapLevelStatus {
+            UNALLOCATED,
+            ALLOCATED_JUST_SET,
+            ALLOCATED_WILL_REMOVE
+        };
+
+        std::vector<sk_sp<SkImage>> mipmapLevels;
+        std::vector<std::atomic<MipmapLevelStatus>> mipmapLevelsStatus;
+        sk_sp<SkImage> smallestMipmapLevel; // Always kept once rasterized, and has auto generated mipmaps. Same as in ImageResourceDisplay
+        std::atomic<bool> smallestMipmapLevelLoaded = false;
+
+        std::shared_ptr<std::string> fileData;
         sk_sp<SkSVGDOM> svgDom;
         bool mustUpdateDraw = false;
         SkSize svgRootSize;
+
+        std::atomic<bool> cancelRaster = false;
+        std::atomic<bool> mustUpdateDrawRasterThread = false;
+
+        std::optional<unsigned> get_exact_mipmap_level_for_dimensions(const Vector2f& pixelDim) const;
+        unsigned get_best_allocated_mipmap_level(unsigned mipmapLevel) const;
+        unsigned get_smallest_mipmap_level() const;
+        SkISize get_mipmap_level_image_dimensions(unsigned mipmapLevel) const;
+        size_t get_mipmap_level_bytes(unsigned mipmapLevel) const;
+        void rasterize_mipmap(unsigned mipmapLevel);
+        void request_rasterize_mipmap(unsigned mipmapLevel, float priority);
 };
@@ -21,6 +21,7 @@
 #include <include/core/SkImage.h>
 #include <Helpers/NetworkingObjects/NetObjID.hpp>
 #include "ResourceDisplay/SvgResourceDisplay.hpp"
+#include "ResourceDisplay/ResourceLoadPool.hpp"
 #include "CommandList.hpp"
 #include "ResourceDisplay/ImageResourceDisplay.hpp"
 #include "ResourceDisplay/FileResourceDisplay.hpp"
@@ -104,6 +105,8 @@ float ResourceManager::get_resource_retrieval_progress(const NetworkingObjects::
 void ResourceManager::update() {
     for(auto& [k, v] : displays)
         v->update(world);
+    // The displays were requested from camera_view_update during this update, so anything left unrequested is no longer needed
+    ResourceLoadPool::get().end_frame();
 }
 
 NetworkingObjects::NetObjTemporaryPtr<ResourceData> ResourceManager::add_resource_file(const std::filesystem::path& filePath) {
@@ -21,6 +21,7 @@
 #include "TextStyleModifier.hpp"
 #include "cereal/archives/portable_binary.hpp"
 #include <include/core/SkFontMetrics.h>
+#include <include/core/SkPictureRecorder.h>
 #include <modules/skparagraph/include/DartTypes.h>
 #include <modules/skparagraph/include/Metrics.h>
 #include <modules/skparagraph/include/Paragraph.h>
@@ -964,6 +965,9 @@ void TextBox::set_font_data(const std::shared_ptr<FontData>& fD) {
 
 void TextBox::rebuild() {
     if(needsRebuild) {
+        paragraphsPicture = nullptr;
+        greekedLines = std::nullopt;
+
         float heightOffset = 0.0f;
 
         auto nextTStyleModIt = tStyleMods.begin();
@@ -1331,11 +1335,56 @@ std::pair<size_t, size_t> TextBox::get_start_end_paragraph_pos(size_t p1, size_t
     return {std::min(p1, p2), std::max(p1, p2)};
 }
 
+const TextBox::GreekedLines& TextBox::get_greeked_lines() {
+    rebuild();
+    if(!greekedLines.has_value()) {
+        constexpr float GREEKED_ALPHA = 0.4f; // Roughly how much of a line's area is covered by its glyphs
+        GreekedLines toRet;
+        for(auto& pData : paragraphs) {
+            std::vector<skia::textlayout::LineMetrics> lineMetrics;
+            pData.p->getLineMetrics(lineMetrics);
+            for(auto& line : lineMetrics) {
+                float baseline = pData.heightOffset + line.fBaseline;
+                toRet.maxLineHeight = std::max(toRet.maxLineHeight, static_cast<float>(line.fHeight));
+                toRet.linesBounds.join(SkRect::MakeLTRB(line.fLeft, baseline - line.fAscent, line.fLeft + line.fWidth, baseline + line.fDescent));
+                if(line.fWidth <= 0.0 || line.fLineMetrics.empty())
+                    continue;
+                const skia::textlayout::TextStyle* lineStyle = line.fLineMetrics.begin()->second.text_style;
+                SkColor4f lineColor = lineStyle->hasForeground() ? lineStyle->getForegroundPaint().getColor4f() : SkColor4f::FromColor(lineStyle->getColor());
+                lineColor.fA *= GREEKED_ALPHA;
+                toRet.lines.emplace_back(SkRect::MakeLTRB(line.fLeft, baseline - line.fAscent * 0.6f, line.fLeft + line.fWidth, baseline), lineColor);
+            }
+        }
+        greekedLines = std::move(toRet);
+    }
+    return greekedLines.value();
+}
+
+float TextBox::get_max_line_height() {
+    return get_greeked_lines().maxLineHeight;
+}
+
+void TextBox::paint_greeked(SkCanvas* canvas, bool skiaAA) {
+    for(auto& line : get_greeked_lines().lines) {
+        SkPaint p(line.color);
+        p.setAntiAlias(skiaAA);
+        canvas->drawRect(line.rect, p);
+    }
+}
+
 void TextBox::paint(SkCanvas* canvas, const PaintOpts& paintOpts) {
     rebuild();
 
-    for(auto& pData : paragraphs)
-        pData.p->paint(canvas, 0.0f, pData.heightOffset);
+    // Painting a paragraph shapes its glyph runs into text blobs again every time, so the result is kept until the next rebuild
+    if(!paragraphsPicture) {
+        const GreekedLines& lineSummary = get_greeked_lines();
+        SkPictureRecorder recorder;
+        SkCanvas* recordingCanvas = recorder.beginRecording(lineSummary.linesBounds.makeOutset(lineSummary.maxLineHeight, lineSummary.maxLineHeight)); // Outset for glyphs and decorations that overhang their line
+        for(auto& pData : paragraphs)
+            pData.p->paint(recordingCanvas, 0.0f, pData.heightOffset);
+        paragraphsPicture = recorder.finishRecordingAsPicture();
+    }
+    canvas->drawPicture(paragraphsPicture);
 
     if(paintOpts.cursor.has_value()) {
         auto& cur = paintOpts.cursor.value();
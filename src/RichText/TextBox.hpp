@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <cwchar>
 #include <include/core/SkCanvas.h>
+#include <include/core/SkPicture.h>
 #include <modules/skparagraph/include/FontCollection.h>
 #include <modules/skparagraph/include/Paragraph.h>
 #include <modules/skparagraph/include/TextStyle.h>
@@ -137,6 +138,9 @@ class TextBox {
         TextPosition remove(TextPosition p1, TextPosition p2);
         void set_font_data(const std::shared_ptr<FontData>& fD);
         void paint(SkCanvas* canvas, const PaintOpts& paintOpts);
+        // Draws each line as a bar in its text color, for when the text is too small to be read
+        void paint_greeked(SkCanvas* canvas, bool skiaAA);
+        float get_max_line_height();
         void set_allow_newlines(bool allow);
         float get_height();
 
@@ -216,6 +220,16 @@ class TextBox {
         void remove_duplicate_text_style_mods();
 
         void rebuild();
+        struct GreekedLine {
+            SkRect rect;
+            SkColor4f color;
+        };
+        struct GreekedLines {
+            std::vector<GreekedLine> lines;
+            float maxLineHeight = 0.0f;
+            SkRect linesBounds = SkRect::MakeEmpty();
+        };
+        const GreekedLines& get_greeked_lines();
         void rebuild_build_run_of_text_with_tabs(std::string_view s, const skia::textlayout::TextStyle& tStyle, skia::textlayout::ParagraphBuilder& a);
 
         int get_line_number_at_from_byte_text_pos(TextPosition pos);
@@ -241,6 +255,10 @@ class TextBox {
         skia::textlayout::TextStyle initialTStyle;
         TextStyleModContainer tStyleMods;
         std::vector<ParagraphData> paragraphs;
+
+        // Glyph runs (as SkTextBlobs) and decorations of every paragraph, recorded the first time they're painted after a rebuild
+        sk_sp<SkPicture> paragraphsPicture;
+        std::optional<GreekedLines> greekedLines;
 };
 
 }
@@ -32,6 +32,9 @@
 #include "Helpers/NetworkingObjects/NetObjGenericSerializedClass.hpp"
 #include "MainProgram.hpp"
 #include "InputManager.hpp"
+#include "RenderStats.hpp"
+#include "CanvasComponents/MeshCanvasComponent.hpp"
+#include "CanvasComponents/TextBoxCanvasComponent.hpp"
 #include "ResourceDisplay/ImageResourceDisplay.hpp"
 #include "RichText/TextStyleModifier.hpp"
 #include "VersionConstants.hpp"
@@ -1699,18 +1702,37 @@ void Toolbar::general_settings_inner_gui() {
                         #endif
                         input_scalars_field(gui, "jump transition easing", "Jump easing", &main.conf.jumpTransitionEasing, 4, -10.0f, 10.0f, { .decimalPrecision = 2 });
                         input_scalar_field<int>(gui, "image load max threads", "Maximum image loading threads", &ImageResourceDisplay::IMAGE_LOAD_THREAD_COUNT_MAX, 1, 10000);
+                        input_scalar_field<size_t>(gui, "resource cache memory budget", "Image and SVG cache memory budget (MB)", &ResourceDisplay::RESOURCE_CACHE_MEMORY_BUDGET_MB, 16, 65536);
+                        text_label_light(gui, "Image and SVG cache memory used (MB): " + std::to_string(ResourceDisplay::get_cache_bytes_resident() / (1024 * 1024)));
                         text_label_light(gui, "Cache related settings");
                         input_scalar_field<size_t>(gui, "cache node resolution", "Cache node resolution", &DrawingProgramCache::CACHE_NODE_RESOLUTION, 256, 8192);
-                        input_scalar_field<size_t>(gui, "max cache nodes", "Maximum cached nodes", &DrawingProgramCache::MAXIMUM_DRAW_CACHE_SURFACES, 2, 10000);
-                        size_t cacheVRAMConsumptionInMB =  ( DrawingProgramCache::MAXIMUM_DRAW_CACHE_SURFACES // Number of surfaces
-                                                           * DrawingProgramCache::CACHE_NODE_RESOLUTION * DrawingProgramCache::CACHE_NODE_RESOLUTION // Number of pixels per cache surface
-                                                           * 4) // 4 Channels per pixel (RGBA)
-                                                           / (1024 * 1024); // Bytes -> Megabytes conversion
-                        text_label_light(gui, "Cache max VRAM consumption (MB): " + std::to_string(cacheVRAMConsumptionInMB));
+                        input_scalar_field<size_t>(gui, "cache memory budget", "Cache VRAM budget (MB)", &DrawingProgramCache::DRAW_CACHE_MEMORY_BUDGET_MB, 16, 65536);
+                        input_scalar_field<size_t>(gui, "cache refresh budget", "Cache refresh time per frame (ms)", &DrawingProgramCache::CACHE_REFRESH_BUDGET_MILLISECONDS, 1, 1000);
+                        const auto& cacheStats = DrawingProgramCache::get_node_cache_stats();
+                        text_label_light(gui, "Cache VRAM used (MB): " + std::to_string((cacheStats.bytesResident + cacheStats.layerCacheBytesResident) / (1024 * 1024)) + " (layer caches: " + std::to_string(cacheStats.layerCacheBytesResident / (1024 * 1024)) + ")");
+                        text_label_light(gui, "Cache hits / misses / evictions: " + std::to_string(cacheStats.hits) + " / " + std::to_string(cacheStats.misses) + " / " + std::to_string(cacheStats.evictions));
                         input_scalar_field<size_t>(gui, "max components in node", "Maximum components in single node", &DrawingProgramCache::MAXIMUM_COMPONENTS_IN_SINGLE_NODE, 2, 10000);
-                        input_scalar_field<size_t>(gui, "components to force cache rebuild", "Number of components to force cache rebuild", &DrawingProgramCache::MINIMUM_COMPONENTS_TO_START_REBUILD, 1, 1000000);
-                        input_scalar_field<size_t>(gui, "maximum frame time to force cache rebuild", "Maximum frame time to force cache rebuild (ms)", &DrawingProgramCache::MILLISECOND_FRAME_TIME_TO_FORCE_CACHE_REFRESH, 1, 1000000);
-                        input_scalar_field<size_t>(gui, "minimum time to force cache rebuild", "Minimum time to check cache rebuild (ms)", &DrawingProgramCache::MILLISECOND_MINIMUM_TIME_TO_CHECK_FORCE_REFRESH, 1, 1000000);
+                        checkbox_boolean_field(gui, "use sah bvh builder", "Use SAH cache tree builder", &DrawingProgramCache::USE_SAH_BVH_BUILDER);
+                        checkbox_boolean_field(gui, "use occlusion culling", "Skip components hidden under opaque components", &DrawingProgramCache::USE_OCCLUSION_CULLING);
+                        input_scalar_field<size_t>(gui, "max cached layers", "Maximum flattened layer caches", &DrawingProgramCache::MAXIMUM_CACHED_LAYERS, 0, 64);
+                        checkbox_boolean_field(gui, "use tile cache", "Draw canvas from tile cache", &DrawingProgramTileCache::USE_TILE_CACHE);
+                        input_scalar_field<size_t>(gui, "tile cache memory budget", "Tile cache VRAM budget (MB)", &DrawingProgramTileCache::TILE_CACHE_MEMORY_BUDGET_MB, 16, 65536);
+                        text_label_light(gui, "Tile cache VRAM used (MB): " + std::to_string(DrawingProgramTileCache::get_tile_bytes_resident() / (1024 * 1024)));
+                        checkbox_boolean_field(gui, "use batched mesh draw", "Draw strokes as batched triangles without Skia antialiasing", &MeshCanvasComponent::USE_BATCHED_DRAW);
+                        checkbox_boolean_field(gui, "use mesh lod", "Draw simplified strokes when zoomed out", &MeshCanvasComponent::USE_LOD);
+                        input_scalar_field<float>(gui, "text greeking pixel height", "Draw text as bars below line height (pixels)", &TextBoxCanvasComponent::GREEKING_PIXEL_HEIGHT, 0.0f, 100.0f, { .decimalPrecision = 1 });
+                        checkbox_boolean_field(gui, "show render stats", "Show render stats overlay", &RenderStats::SHOW_OVERLAY);
+                        text_button_wide("dump render stats", "Dump render stats (JSON)", [&] {
+                            RenderStats::dump_last_frame(main.conf.configPath / "render_stats.json");
+                        });
+                        if(main.world) {
+                            text_button_wide("log bvh occupancy", "Log cache tree occupancy (quadtree vs SAH)", [&] {
+                                main.world->drawProg.drawCache.log_bvh_occupancy_comparison();
+                            });
+                            text_button_wide("log batched mesh draw comparison", "Log batched stroke draw difference from path fill", [&] {
+                                MeshCanvasComponent::log_batched_draw_comparison(main.world->drawProg, main.world->drawData);
+                            });
+                        }
                     });
                     break;
                 }
@@ -340,10 +340,7 @@ void WorldGrid::draw(GridManager& gMan, SkCanvas* canvas, const DrawData& drawDa
     canvas->save();
     if(bounds.has_value()) {
         const auto& b = bounds.value();
-        Vector2f b1 = drawData.cam.c.to_space(b.min);
-        Vector2f b2 = drawData.cam.c.to_space(b.top_right());
-        Vector2f b3 = drawData.cam.c.to_space(b.max);
-        Vector2f b4 = drawData.cam.c.to_space(b.bottom_left());
+        auto [b1, b2, b3, b4] = drawData.cam.c.aabb_corners_to_space(b);
         SkPathBuilder clipPath;
         clipPath.moveTo(b1.x(), b1.y());
         clipPath.lineTo(b2.x(), b2.y());
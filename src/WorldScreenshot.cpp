@@ -154,10 +154,9 @@ void take_screenshot_svg(const std::shared_ptr<World>& w, SkCanvas* canvas, bool
 
     Vector2f canvasSize{imageBounds.max.x() - imageBounds.min.x(), imageBounds.max.y() - imageBounds.min.y()};
 
-    WorldVec topLeft = cameraCoords.from_space({secRectX1, secRectY1});
-    WorldVec topRight = cameraCoords.from_space({secRectX2, secRectY1});
-    WorldVec bottomLeft = cameraCoords.from_space({secRectX1, secRectY2});
-    WorldVec bottomRight = cameraCoords.from_space({secRectX2, secRectY2});
+    auto [topLeft, topRight, bottomLeft, bottomRight] = cameraCoords.from_space(std::array<Vector2f, 4>{
+        Vector2f{secRectX1, secRectY1}, Vector2f{secRectX2, secRectY1}, Vector2f{secRectX1, secRectY2}, Vector2f{secRectX2, secRectY2}
+    });
     WorldVec camCenter = (topLeft + bottomRight) / WorldScalar(2);
 
     WorldVec vectorZoom;
@@ -184,10 +183,9 @@ void take_screenshot_area_hw(const std::shared_ptr<World>& w, const sk_sp<SkSurf
     float secRectY1 = imageBounds.min.y() + (imageBounds.max.y() - imageBounds.min.y()) * (sectionImagePos.y() / (double)fullImageSize.y());
     float secRectY2 = imageBounds.min.y() + (imageBounds.max.y() - imageBounds.min.y()) * ((sectionImagePos.y() + canvasSize.y()) / (double)fullImageSize.y());
 
-    WorldVec topLeft = cameraCoords.from_space({secRectX1, secRectY1});
-    WorldVec topRight = cameraCoords.from_space({secRectX2, secRectY1});
-    WorldVec bottomLeft = cameraCoords.from_space({secRectX1, secRectY2});
-    WorldVec bottomRight = cameraCoords.from_space({secRectX2, secRectY2});
+    auto [topLeft, topRight, bottomLeft, bottomRight] = cameraCoords.from_space(std::array<Vector2f, 4>{
+        Vector2f{secRectX1, secRectY1}, Vector2f{secRectX2, secRectY1}, Vector2f{secRectX1, secRectY2}, Vector2f{secRectX2, secRectY2}
+    });
     WorldVec camCenter = (topLeft + bottomRight) / WorldScalar(2);
 
     WorldVec vectorZoom;
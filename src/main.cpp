@@ -64,6 +64,7 @@
 #include <cereal/types/string.hpp>
 
 #include "MainProgram.hpp"
+#include "RenderStats.hpp"
 
 #include <include/codec/SkPngDecoder.h>
 
@@ -591,6 +592,7 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv) {
 
 void regular_draw(MainStruct& mS) {
     mS.lastRenderTimePoint = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point flushTimeStart;
 
     if(mS.m->window.intermediateSurfaceMSAA) {
         SkCanvas* intermediateCanvas = mS.m->window.intermediateSurfaceMSAA->getCanvas();
@@ -598,6 +600,7 @@ void regular_draw(MainStruct& mS) {
         intermediateCanvas->translate(mS.m->input.screenOffset.x(), mS.m->input.screenOffset.y());
         mS.m->draw(intermediateCanvas);
         intermediateCanvas->restore();
+        flushTimeStart = std::chrono::steady_clock::now();
 
         #ifdef USE_BACKEND_VULKAN
             mS.vulkanWindowContext->getBackbufferSurface()->getCanvas()->drawImage(mS.m->window.intermediateSurfaceMSAA->makeTemporaryImage(), 0, 0);
@@ -612,6 +615,7 @@ void regular_draw(MainStruct& mS) {
     else {
         #ifdef USE_BACKEND_VULKAN
             mS.m->draw(mS.vulkanWindowContext->getBackbufferSurface()->getCanvas());
+            flushTimeStart = std::chrono::steady_clock::now();
             mS.ctx->flushAndSubmit();
             mS.vulkanWindowContext->swapBuffers();
         #elif USE_BACKEND_OPENGL
@@ -619,10 +623,15 @@ void regular_draw(MainStruct& mS) {
             mS.canvas->translate(mS.m->input.screenOffset.x(), mS.m->input.screenOffset.y());
             mS.m->draw(mS.canvas);
             mS.canvas->restore();
+            flushTimeStart = std::chrono::steady_clock::now();
             mS.ctx->flushAndSubmit();
             SDL_GL_SwapWindow(mS.window);
         #endif
     }
+
+    RenderStats::Frame& stats = RenderStats::current();
+    stats.drawTime = flushTimeStart - mS.lastRenderTimePoint;
+    stats.flushTime = std::chrono::steady_clock::now() - flushTimeStart;
 }
 
 SDL_AppResult SDL_AppIterate(void *appstate) {
@@ -635,6 +644,7 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
     try {
 #endif
         mS.m->update();
+        RenderStats::current().updateTime = std::chrono::steady_clock::now() - mS.lastUpdateTimePoint;
 
         if(mS.m->setToQuit) {
             #ifdef __ANDROID__
@@ -653,6 +663,7 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
         }
 
         regular_draw(mS);
+        RenderStats::end_frame();
 
         mS.m->input.frame_reset(mS.m->window.size);
 #ifdef NDEBUG
@@ -0,0 +1,94 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Checks the batched conversions against the per point ones. The batched path subtracts the origin before dividing by the scale,
+// so results differ by rounding only
+
+#include "CoordSpaceHelper.hpp"
+#include <gtest/gtest.h>
+#include <numbers>
+#include <random>
+
+namespace {
+
+constexpr float SCREEN_TOLERANCE_PIXELS = 1.0f / 256.0f;
+constexpr size_t POINT_COUNT = 203; // Not a multiple of the chunk or vector width, so the tails get checked too
+
+CoordSpaceHelper random_camera(std::mt19937& gen, const WorldScalar& base) {
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    WorldScalar scale = base.multiply_double(0.001 + dist(gen));
+    return CoordSpaceHelper(WorldVec{base.multiply_double(dist(gen)), -base.multiply_double(dist(gen))}, scale, dist(gen) * 2.0 * std::numbers::pi);
+}
+
+std::vector<WorldVec> random_points_near(std::mt19937& gen, const CoordSpaceHelper& cam) {
+    std::uniform_real_distribution<float> dist(-500.0f, 2500.0f);
+    std::vector<WorldVec> toRet;
+    for(size_t i = 0; i < POINT_COUNT; i++)
+        toRet.emplace_back(cam.from_space(Vector2f{dist(gen), dist(gen)}));
+    return toRet;
+}
+
+}
+
+TEST(CoordSpaceHelper, BatchedToSpaceMatchesScalar) {
+    std::mt19937 gen(5);
+    for(int shift : {-20, 0, 40, 300}) {
+        WorldScalar base = shift >= 0 ? (WorldScalar(1) << shift) : (WorldScalar(1) >> -shift);
+        CoordSpaceHelper cam = random_camera(gen, base);
+        std::vector<WorldVec> points = random_points_near(gen, cam);
+        std::vector<Vector2f> batched = cam.to_space(points);
+        for(size_t i = 0; i < points.size(); i++) {
+            Vector2f scalar = cam.to_space(points[i]);
+            EXPECT_NEAR(batched[i].x(), scalar.x(), SCREEN_TOLERANCE_PIXELS) << "shift " << shift << " point " << i;
+            EXPECT_NEAR(batched[i].y(), scalar.y(), SCREEN_TOLERANCE_PIXELS) << "shift " << shift << " point " << i;
+        }
+    }
+}
+
+TEST(CoordSpaceHelper, BatchedFromSpaceMatchesScalar) {
+    std::mt19937 gen(6);
+    std::uniform_real_distribution<float> dist(-500.0f, 2500.0f);
+    CoordSpaceHelper cam = random_camera(gen, WorldScalar(1) << 40);
+    std::vector<Vector2f> points;
+    for(size_t i = 0; i < POINT_COUNT; i++)
+        points.emplace_back(dist(gen), dist(gen));
+    std::vector<WorldVec> batched = cam.from_space(points);
+    for(size_t i = 0; i < points.size(); i++) {
+        Vector2f roundTrip = cam.to_space(batched[i]);
+        EXPECT_NEAR(roundTrip.x(), points[i].x(), SCREEN_TOLERANCE_PIXELS);
+        EXPECT_NEAR(roundTrip.y(), points[i].y(), SCREEN_TOLERANCE_PIXELS);
+    }
+}
+
+// Offsets from the camera that are too large for a double still have to convert, since the exact path divides by the scale first
+TEST(CoordSpaceHelper, BatchedToSpaceHandlesOffsetsOutsideDoubleRange) {
+    WorldScalar scale = WorldScalar(1) << 985;
+    CoordSpaceHelper cam(WorldVec{WorldScalar(0), WorldScalar(0)}, scale, 0.25);
+    std::vector<WorldVec> points{
+        WorldVec{scale * WorldScalar(100), scale * WorldScalar(-40)},
+        WorldVec{WorldScalar(0), WorldScalar(0)},
+        WorldVec{scale * WorldScalar(-3000), scale * WorldScalar(700)}
+    };
+    std::vector<Vector2f> batched = cam.to_space(points);
+    for(size_t i = 0; i < points.size(); i++) {
+        Vector2f scalar = cam.to_space(points[i]);
+        ASSERT_TRUE(std::isfinite(batched[i].x()) && std::isfinite(batched[i].y())) << "point " << i;
+        EXPECT_NEAR(batched[i].x(), scalar.x(), SCREEN_TOLERANCE_PIXELS);
+        EXPECT_NEAR(batched[i].y(), scalar.y(), SCREEN_TOLERANCE_PIXELS);
+    }
+}
@@ -0,0 +1,119 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Helpers/FixedPoint.hpp>
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/types/vector.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace {
+
+TEST(FixedPointPowInt, ZeroExponentIsOne) {
+    EXPECT_EQ(FixedPoint::pow_int(WorldScalar(7), 0), WorldScalar(1));
+}
+
+TEST(FixedPointPowInt, MatchesRepeatedMultiplication) {
+    // Used to square the value on each step, which returns x^(2^(exp-1)). The exponents past 2 are where that differed
+    for(uint64_t exp = 0; exp <= 12; exp++) {
+        WorldScalar expected(1);
+        for(uint64_t i = 0; i < exp; i++)
+            expected *= WorldScalar(3);
+        EXPECT_EQ(FixedPoint::pow_int(WorldScalar(3), exp), expected) << "exp = " << exp;
+    }
+}
+
+TEST(FixedPointPowInt, CanvasScaleUpStep) {
+    // Same step as CANVAS_SCALE_UP_STEP in ScaleUpCanvas.hpp, a client three scale ups behind needs 10^150
+    const WorldScalar scaleUpStep("100000000000000000000000000000000000000000000000000");
+    EXPECT_EQ(FixedPoint::pow_int(scaleUpStep, 3), scaleUpStep * scaleUpStep * scaleUpStep);
+    EXPECT_EQ(FixedPoint::pow_int(scaleUpStep, 1), scaleUpStep);
+}
+
+TEST(FixedPointPowInt, Fractions) {
+    EXPECT_EQ(FixedPoint::pow_int(WorldScalar(0.5), 5), WorldScalar(0.03125));
+}
+
+WorldScalar from_underlying(const boost::multiprecision::cpp_int& a) {
+    return WorldScalar(FixedPoint::HybridInt(a), true);
+}
+
+WorldScalar save_and_load(const WorldScalar& a) {
+    std::stringstream ss;
+    {
+        cereal::PortableBinaryOutputArchive out(ss);
+        out(a);
+    }
+    WorldScalar toRet;
+    cereal::PortableBinaryInputArchive in(ss);
+    in(toRet);
+    return toRet;
+}
+
+std::vector<boost::multiprecision::cpp_int> serialization_values() {
+    using boost::multiprecision::cpp_int;
+    cpp_int int128Max = (cpp_int(1) << 127) - 1;
+    cpp_int int128Min = -(cpp_int(1) << 127);
+    return {0, 1, -1, 127, -128, std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min(),
+            cpp_int(std::numeric_limits<int64_t>::max()) + 1, cpp_int(std::numeric_limits<int64_t>::min()) - 1,
+            int128Max, int128Min, int128Max >> 2, int128Min >> 2, (int128Max >> 2) + 1, (int128Min >> 2) - 1,
+            int128Max + 1, int128Min - 1, cpp_int(1) << 400, -(cpp_int(1) << 400) - 3};
+}
+
+TEST(FixedPointSerialization, RoundTripsUnderlyingValues) {
+    for(const auto& v : serialization_values()) {
+        WorldScalar loaded = save_and_load(from_underlying(v));
+        EXPECT_EQ(to_big_int(loaded.get_underlying_val()), v) << v;
+    }
+}
+
+TEST(FixedPointSerialization, RoundTripsScalars) {
+    for(const WorldScalar& v : {WorldScalar(0), WorldScalar(1), WorldScalar(-1), WorldScalar(0.5), WorldScalar(-1234.25),
+                                WorldScalar("100000000000000000000000000000000000000000000000000")})
+        EXPECT_EQ(save_and_load(v), v) << v;
+}
+
+TEST(FixedPointSerialization, SmallValuesUseFewBytes) {
+    std::stringstream ss;
+    {
+        cereal::PortableBinaryOutputArchive out(ss);
+        out(from_underlying(1));
+    }
+    // One byte for the archive endianness, one for the value
+    EXPECT_EQ(ss.str().size(), 2u);
+}
+
+TEST(FixedPointSerialization, LoadsOldFormat) {
+    // Files saved before the varint format stored a sign bool, followed by the absolute value as a big endian byte vector
+    for(const auto& v : serialization_values()) {
+        std::stringstream ss;
+        {
+            cereal::PortableBinaryOutputArchive out(ss);
+            bool isNegative = v < 0;
+            std::vector<uint8_t> bytes;
+            boost::multiprecision::export_bits(boost::multiprecision::cpp_int(abs(v)), std::back_inserter(bytes), 8, true);
+            out(isNegative, bytes);
+        }
+        WorldScalar loaded;
+        cereal::PortableBinaryInputArchive in(ss);
+        in(loaded);
+        EXPECT_EQ(to_big_int(loaded.get_underlying_val()), v) << v;
+    }
+}
+
+}
@@ -0,0 +1,147 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Helpers/HybridInt.hpp>
+#include <gtest/gtest.h>
+
+namespace {
+
+using FixedPoint::HybridInt;
+using BigInt = boost::multiprecision::cpp_int;
+
+BigInt small_max() {
+    return BigInt(HybridInt::SMALL_MAX);
+}
+
+BigInt small_min() {
+    return BigInt(HybridInt::SMALL_MIN);
+}
+
+// Values around the edges of the inline integer, plus some that are only representable by cpp_int
+std::vector<BigInt> edge_values() {
+    std::vector<BigInt> toRet{0, 1, -1, 2, -2, 7, -7, 1000003, -1000003,
+                              std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min(),
+                              BigInt(std::numeric_limits<int64_t>::max()) + 1, BigInt(std::numeric_limits<int64_t>::min()) - 1,
+                              small_max(), small_min(), small_max() - 1, small_min() + 1, small_max() + 1, small_min() - 1,
+                              small_max() * 3, small_min() * 5, BigInt(1) << 300, -(BigInt(1) << 300) + 12345};
+    return toRet;
+}
+
+TEST(HybridInt, PromotesOnOverflowAndDemotesBack) {
+    HybridInt a(small_max());
+    EXPECT_TRUE(a.is_small());
+
+    HybridInt b = a + HybridInt(1);
+    EXPECT_FALSE(b.is_small());
+    EXPECT_EQ(b.to_big_int(), small_max() + 1);
+
+    HybridInt c = b - HybridInt(1);
+    EXPECT_TRUE(c.is_small());
+    EXPECT_EQ(c, a);
+
+    HybridInt d = HybridInt(small_min()) - HybridInt(1);
+    EXPECT_FALSE(d.is_small());
+    EXPECT_EQ(d.to_big_int(), small_min() - 1);
+    EXPECT_TRUE((d + HybridInt(1)).is_small());
+
+    HybridInt e = a * HybridInt(4);
+    EXPECT_FALSE(e.is_small());
+    EXPECT_EQ(e.to_big_int(), small_max() * 4);
+    HybridInt f = e / HybridInt(4);
+    EXPECT_TRUE(f.is_small());
+    EXPECT_EQ(f, a);
+
+    // Negating the minimum doesn't fit either
+    HybridInt g = -HybridInt(small_min());
+    EXPECT_FALSE(g.is_small());
+    EXPECT_EQ(g.to_big_int(), -small_min());
+    EXPECT_TRUE((-g).is_small());
+}
+
+TEST(HybridInt, ArithmeticMatchesCppInt) {
+    std::vector<BigInt> values = edge_values();
+    for(const BigInt& x : values) {
+        for(const BigInt& y : values) {
+            HybridInt hx(x);
+            HybridInt hy(y);
+            EXPECT_EQ((hx + hy).to_big_int(), x + y) << x << " + " << y;
+            EXPECT_EQ((hx - hy).to_big_int(), x - y) << x << " - " << y;
+            EXPECT_EQ((hx * hy).to_big_int(), x * y) << x << " * " << y;
+            EXPECT_EQ(hx < hy, x < y) << x << " < " << y;
+            EXPECT_EQ(hx == hy, x == y) << x << " == " << y;
+        }
+    }
+}
+
+TEST(HybridInt, DivisionTruncatesLikeCppInt) {
+    EXPECT_EQ(HybridInt(-7) / HybridInt(2), HybridInt(-3));
+    EXPECT_EQ(HybridInt(-7) % HybridInt(2), HybridInt(-1));
+    EXPECT_EQ(HybridInt(7) / HybridInt(-2), HybridInt(-3));
+    EXPECT_EQ(HybridInt(7) % HybridInt(-2), HybridInt(1));
+
+    std::vector<BigInt> values = edge_values();
+    for(const BigInt& x : values) {
+        for(const BigInt& y : values) {
+            if(y == 0)
+                continue;
+            HybridInt hx(x);
+            HybridInt hy(y);
+            EXPECT_EQ((hx / hy).to_big_int(), x / y) << x << " / " << y;
+            EXPECT_EQ((hx % hy).to_big_int(), x % y) << x << " % " << y;
+        }
+    }
+
+    EXPECT_THROW(HybridInt(5) / HybridInt(0), std::overflow_error);
+    EXPECT_THROW(HybridInt(5) % HybridInt(0), std::overflow_error);
+}
+
+TEST(HybridInt, ShiftsMatchCppIntOnNegativeValues) {
+    EXPECT_EQ(HybridInt(-1) >> 1, HybridInt(-1));
+    EXPECT_EQ(HybridInt(-5) >> 1, HybridInt(-3));
+    EXPECT_EQ(HybridInt(-5) << 3, HybridInt(-40));
+
+    for(const BigInt& x : edge_values()) {
+        HybridInt hx(x);
+        for(int shift : {0, 1, 7, 32, 63, 64, 65, 126, 127, 128, 129, 200}) {
+            EXPECT_EQ((hx << shift).to_big_int(), x << shift) << x << " << " << shift;
+            EXPECT_EQ((hx >> shift).to_big_int(), x >> shift) << x << " >> " << shift;
+        }
+    }
+}
+
+TEST(HybridInt, ConvertsToDoubleLikeCppInt) {
+    for(const BigInt& x : edge_values())
+        EXPECT_EQ(static_cast<double>(HybridInt(x)), x.convert_to<double>()) << x;
+    EXPECT_EQ(static_cast<double>(HybridInt(-3)), -3.0);
+    EXPECT_EQ(static_cast<double>(HybridInt(1.75e30)), static_cast<double>(BigInt(1.75e30)));
+}
+
+TEST(HybridInt, ConvertsToInt64LikeCppInt) {
+    for(const BigInt& x : edge_values())
+        EXPECT_EQ(static_cast<int64_t>(HybridInt(x)), x.convert_to<int64_t>()) << x;
+    // Out of range values saturate
+    EXPECT_EQ(static_cast<int64_t>(HybridInt(small_max())), std::numeric_limits<int64_t>::max());
+    EXPECT_EQ(static_cast<int64_t>(HybridInt(small_min() - 1)), std::numeric_limits<int64_t>::min());
+}
+
+TEST(HybridInt, StringMatchesCppInt) {
+    for(const BigInt& x : edge_values())
+        EXPECT_EQ(HybridInt(x).str(), x.str()) << x;
+}
+
+}
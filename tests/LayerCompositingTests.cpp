@@ -0,0 +1,201 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Layers and folders that don't need an offscreen layer are drawn straight into their parent. These tests draw the same layer tree
+// with an offscreen layer for every item and with the elided ones drawn directly, and check that the pixels are identical.
+// Antialiasing is off and every color and alpha is a power of 2 fraction, so that the float surface composites them without rounding
+
+#include "DrawingProgram/Layers/SerializedBlendMode.hpp"
+#include <gtest/gtest.h>
+#include <include/core/SkCanvas.h>
+#include <include/core/SkPaint.h>
+#include <include/core/SkPixmap.h>
+#include <include/core/SkSurface.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr int SURFACE_SIZE = 128;
+
+struct TestShape {
+    SkRect rect;
+    SkColor4f color;
+    bool isOval = false;
+};
+
+// Mirrors the parts of DrawingProgramLayerListItem that decide how it's composited
+struct TestItem {
+    float alpha = 1.0f;
+    SerializedBlendMode blendMode = SerializedBlendMode::BLEND_SRC_OVER;
+    bool visible = true;
+    bool isFolder = false;
+    std::vector<TestShape> shapes; // Layers only
+    std::vector<TestItem> children; // Folders only, from bottom to top
+};
+
+TestItem make_layer(std::vector<TestShape> shapes, float alpha = 1.0f, SerializedBlendMode blendMode = SerializedBlendMode::BLEND_SRC_OVER) {
+    TestItem toRet;
+    toRet.alpha = alpha;
+    toRet.blendMode = blendMode;
+    toRet.shapes = std::move(shapes);
+    return toRet;
+}
+
+TestItem make_folder(std::vector<TestItem> children, float alpha = 1.0f, SerializedBlendMode blendMode = SerializedBlendMode::BLEND_SRC_OVER) {
+    TestItem toRet;
+    toRet.alpha = alpha;
+    toRet.blendMode = blendMode;
+    toRet.isFolder = true;
+    toRet.children = std::move(children);
+    return toRet;
+}
+
+TestItem make_background_layer() {
+    return make_layer({{SkRect::MakeLTRB(0, 0, 96, 128), {0.25f, 0.5f, 0.75f, 1.0f}},
+                       {SkRect::MakeLTRB(64, 0, 128, 80), {1.0f, 0.5f, 0.0f, 0.5f}}});
+}
+
+enum class OffscreenLayers {
+    ALWAYS,
+    ELIDED,
+    ELIDED_IGNORING_CHILD_BLEND_MODES // Wrong on purpose, to check that the scenes depend on the child blend mode rule
+};
+
+// Same steps as DrawingProgramLayerListItem::draw
+void draw_item(const TestItem& item, SkCanvas* canvas, OffscreenLayers offscreenLayers, int& saveLayerCount) {
+    if(!item.visible)
+        return;
+    bool hasVisibleChildWithOtherBlendMode = std::any_of(item.children.begin(), item.children.end(), [](const TestItem& child) {
+        return child.visible && child.blendMode != SerializedBlendMode::BLEND_SRC_OVER;
+    });
+    if(offscreenLayers == OffscreenLayers::ELIDED_IGNORING_CHILD_BLEND_MODES)
+        hasVisibleChildWithOtherBlendMode = false;
+    bool drawInOffscreenLayer = offscreenLayers == OffscreenLayers::ALWAYS || layer_needs_offscreen_layer(item.alpha, item.blendMode, hasVisibleChildWithOtherBlendMode);
+    if(drawInOffscreenLayer) {
+        SkPaint layerPaint;
+        layerPaint.setAlphaf(item.alpha);
+        layerPaint.setBlendMode(serialized_blend_mode_to_sk_blend_mode(item.blendMode));
+        canvas->saveLayer(nullptr, &layerPaint);
+        saveLayerCount++;
+    }
+    if(item.isFolder) {
+        for(const TestItem& child : item.children)
+            draw_item(child, canvas, offscreenLayers, saveLayerCount);
+    }
+    else {
+        for(const TestShape& shape : item.shapes) {
+            SkPaint paint;
+            paint.setColor4f(shape.color);
+            paint.setAntiAlias(false);
+            if(shape.isOval)
+                canvas->drawOval(shape.rect, paint);
+            else
+                canvas->drawRect(shape.rect, paint);
+        }
+    }
+    if(drawInOffscreenLayer)
+        canvas->restore();
+}
+
+sk_sp<SkSurface> draw_scene(const TestItem& root, OffscreenLayers offscreenLayers, int& saveLayerCount) {
+    sk_sp<SkSurface> surface = SkSurfaces::Raster(SkImageInfo::Make(SURFACE_SIZE, SURFACE_SIZE, kRGBA_F32_SkColorType, kPremul_SkAlphaType));
+    surface->getCanvas()->clear(SkColor4f{0.0f, 0.0f, 0.0f, 0.0f});
+    saveLayerCount = 0;
+    draw_item(root, surface->getCanvas(), offscreenLayers, saveLayerCount);
+    return surface;
+}
+
+size_t count_different_pixels(const sk_sp<SkSurface>& a, const sk_sp<SkSurface>& b) {
+    SkPixmap aPixels;
+    SkPixmap bPixels;
+    if(!a->peekPixels(&aPixels) || !b->peekPixels(&bPixels))
+        return SURFACE_SIZE * SURFACE_SIZE;
+    size_t toRet = 0;
+    for(int y = 0; y < SURFACE_SIZE; y++) {
+        for(int x = 0; x < SURFACE_SIZE; x++) {
+            if(std::memcmp(aPixels.addr(x, y), bPixels.addr(x, y), aPixels.info().bytesPerPixel()) != 0)
+                toRet++;
+        }
+    }
+    return toRet;
+}
+
+// Returns the number of offscreen layers that were elided
+int expect_elided_scene_matches(const TestItem& root) {
+    int allLayersCount;
+    int elidedLayersCount;
+    sk_sp<SkSurface> allLayers = draw_scene(root, OffscreenLayers::ALWAYS, allLayersCount);
+    sk_sp<SkSurface> elidedLayers = draw_scene(root, OffscreenLayers::ELIDED, elidedLayersCount);
+    EXPECT_EQ(count_different_pixels(allLayers, elidedLayers), 0u);
+    return allLayersCount - elidedLayersCount;
+}
+
+// Drawn from bottom to top, partly overlapping each other and the background
+TestItem make_overlapping_layer(float offset, float alpha = 1.0f) {
+    return make_layer({{SkRect::MakeXYWH(8 + offset, 16 + offset, 48, 40), {0.5f, 0.25f, 1.0f, 0.5f}},
+                       {SkRect::MakeXYWH(24 + offset, 4 + offset, 40, 56), {1.0f, 0.75f, 0.25f, 0.75f}, true},
+                       {SkRect::MakeXYWH(offset, 48 + offset, 32, 24), {0.0f, 0.5f, 0.25f, 1.0f}}}, alpha);
+}
+
+}
+
+TEST(LayerOffscreenElision, OpaqueSourceOverLayers) {
+    TestItem root = make_folder({make_background_layer(), make_overlapping_layer(0), make_overlapping_layer(20), make_overlapping_layer(44)});
+    // Nothing needs an offscreen layer, including the root folder
+    EXPECT_EQ(expect_elided_scene_matches(root), 5);
+}
+
+TEST(LayerOffscreenElision, TranslucentLayersKeepTheirOffscreenLayer) {
+    TestItem root = make_folder({make_background_layer(), make_overlapping_layer(0), make_overlapping_layer(20, 0.5f), make_overlapping_layer(44)});
+    EXPECT_EQ(expect_elided_scene_matches(root), 4);
+}
+
+TEST(LayerOffscreenElision, FolderWithOtherBlendModeChild) {
+    TestItem folder = make_folder({make_overlapping_layer(0),
+                                   make_layer({{SkRect::MakeXYWH(16, 16, 96, 64), {0.5f, 1.0f, 0.25f, 1.0f}}}, 1.0f, SerializedBlendMode::BLEND_MULTIPLY),
+                                   make_overlapping_layer(40)});
+    TestItem root = make_folder({make_background_layer(), folder});
+    // Only the root folder, the background layer and the two source over layers in the folder are elided
+    EXPECT_EQ(expect_elided_scene_matches(root), 4);
+
+    // The multiply layer would blend with the background too if the folder was drawn straight onto the canvas
+    int layerCount;
+    sk_sp<SkSurface> allLayers = draw_scene(root, OffscreenLayers::ALWAYS, layerCount);
+    sk_sp<SkSurface> folderElided = draw_scene(root, OffscreenLayers::ELIDED_IGNORING_CHILD_BLEND_MODES, layerCount);
+    EXPECT_GT(count_different_pixels(allLayers, folderElided), 0u);
+}
+
+TEST(LayerOffscreenElision, HiddenChildWithOtherBlendModeIsIgnored) {
+    TestItem hiddenLayer = make_layer({{SkRect::MakeXYWH(0, 0, 128, 128), {1.0f, 0.0f, 0.0f, 1.0f}}}, 1.0f, SerializedBlendMode::BLEND_DIFFERENCE);
+    hiddenLayer.visible = false;
+    TestItem root = make_folder({make_background_layer(), make_folder({make_overlapping_layer(0), hiddenLayer, make_overlapping_layer(30)})});
+    EXPECT_EQ(expect_elided_scene_matches(root), 5);
+}
+
+TEST(LayerOffscreenElision, NestedFolders) {
+    TestItem innermost = make_folder({make_overlapping_layer(10),
+                                      make_layer({{SkRect::MakeXYWH(20, 40, 80, 80), {0.25f, 0.5f, 1.0f, 0.5f}, true}}, 1.0f, SerializedBlendMode::BLEND_SCREEN),
+                                      make_overlapping_layer(50)});
+    TestItem translucent = make_folder({make_overlapping_layer(4), make_folder({make_overlapping_layer(36)})}, 0.5f);
+    TestItem root = make_folder({make_background_layer(),
+                                 make_folder({make_overlapping_layer(0), make_folder({innermost, make_overlapping_layer(60)})}),
+                                 translucent,
+                                 make_folder({make_folder({make_folder({make_overlapping_layer(70)})})}, 1.0f, SerializedBlendMode::BLEND_DIFFERENCE)});
+    EXPECT_GT(expect_elided_scene_matches(root), 0);
+}
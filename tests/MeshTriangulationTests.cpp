@@ -0,0 +1,157 @@
+/*
+ * InfiniPaint
+ * Copyright (C) 2025-2026 Yousef Khadadeh
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// Checks the batched mesh draw against the path fill it replaces. Both are drawn without antialiasing on CPU raster surfaces, since
+// that's the only case where batching is used. The triangles cover the same pixel centers as the path, so only pixels whose centers
+// are within rounding distance of an edge can differ
+
+#include "CanvasComponents/MeshTriangulation.hpp"
+#include <gtest/gtest.h>
+#include <include/core/SkCanvas.h>
+#include <include/core/SkPathBuilder.h>
+#include <include/core/SkPixmap.h>
+#include <include/core/SkSurface.h>
+#include <include/core/SkVertices.h>
+#include <numbers>
+
+namespace {
+
+constexpr int SURFACE_SIZE = 512;
+constexpr double MAXIMUM_DIFFERENT_PIXEL_FRACTION = 0.01; // Of the pixels covered by the path fill
+
+struct TestMesh {
+    SkPath path;
+    SkMatrix transform;
+};
+
+// Outlines like the ones strokes are turned into: a bent stroke, a ring with a hole, and a round dot
+std::vector<TestMesh> get_test_meshes() {
+    std::vector<TestMesh> toRet;
+
+    SkPathBuilder bentStroke;
+    bentStroke.moveTo(0, 0);
+    bentStroke.lineTo(100, 40);
+    bentStroke.lineTo(180, 10);
+    bentStroke.lineTo(185, 30);
+    bentStroke.lineTo(100, 62);
+    bentStroke.lineTo(-5, 20);
+    bentStroke.close();
+    SkMatrix bentStrokeTransform = SkMatrix::Translate(40, 60);
+    bentStrokeTransform.preRotate(15);
+    bentStrokeTransform.preScale(1.3f, 1.3f);
+    toRet.emplace_back(bentStroke.detach(), bentStrokeTransform);
+
+    SkPathBuilder ring;
+    ring.moveTo(0, 0);
+    ring.lineTo(120, 0);
+    ring.lineTo(120, 120);
+    ring.lineTo(0, 120);
+    ring.close();
+    ring.moveTo(30, 30);
+    ring.lineTo(30, 90);
+    ring.lineTo(90, 90);
+    ring.lineTo(90, 30);
+    ring.close();
+    SkMatrix ringTransform = SkMatrix::Translate(300, 250);
+    ringTransform.preRotate(-40);
+    toRet.emplace_back(ring.detach(), ringTransform);
+
+    SkPathBuilder dot;
+    constexpr int DOT_SIDES = 40;
+    for(int i = 0; i < DOT_SIDES; i++) {
+        double angle = 2.0 * std::numbers::pi * i / DOT_SIDES;
+        SkPoint p{static_cast<float>(std::cos(angle) * 10.0), static_cast<float>(std::sin(angle) * 10.0)};
+        if(i == 0)
+            dot.moveTo(p);
+        else
+            dot.lineTo(p);
+    }
+    dot.close();
+    SkMatrix dotTransform = SkMatrix::Translate(150, 380);
+    dotTransform.preScale(6.5f, 6.5f);
+    toRet.emplace_back(dot.detach(), dotTransform);
+
+    return toRet;
+}
+
+sk_sp<SkSurface> make_cleared_surface() {
+    sk_sp<SkSurface> surface = SkSurfaces::Raster(SkImageInfo::MakeN32Premul(SURFACE_SIZE, SURFACE_SIZE));
+    surface->getCanvas()->clear(SkColor4f{0.0f, 0.0f, 0.0f, 0.0f});
+    return surface;
+}
+
+SkPaint get_mesh_paint() {
+    SkPaint paint;
+    paint.setColor4f(SkColor4f{0.2f, 0.4f, 0.8f, 1.0f});
+    paint.setAntiAlias(false);
+    return paint;
+}
+
+}
+
+TEST(MeshTriangulation, BatchedDrawMatchesPathFill) {
+    std::vector<TestMesh> meshes = get_test_meshes();
+    SkPaint paint = get_mesh_paint();
+
+    sk_sp<SkSurface> pathFillSurface = make_cleared_surface();
+    for(auto& mesh : meshes) {
+        SkCanvas* canvas = pathFillSurface->getCanvas();
+        canvas->save();
+        canvas->concat(mesh.transform);
+        canvas->drawPath(mesh.path, paint);
+        canvas->restore();
+    }
+
+    // Same as MeshCanvasComponent::draw_batch, with every mesh merged into one draw
+    std::vector<SkPoint> batchPoints;
+    for(auto& mesh : meshes) {
+        std::shared_ptr<const MeshTriangulation> triangulation = MeshTriangulation::triangulate_path(mesh.path);
+        ASSERT_FALSE(triangulation->trianglePoints.empty());
+        ASSERT_EQ(triangulation->trianglePoints.size() % 3, 0u);
+        triangulation->append_mapped_triangle_points(batchPoints, mesh.transform);
+    }
+    sk_sp<SkSurface> batchedSurface = make_cleared_surface();
+    batchedSurface->getCanvas()->drawVertices(SkVertices::MakeCopy(SkVertices::kTriangles_VertexMode, static_cast<int>(batchPoints.size()), batchPoints.data(), nullptr, nullptr), SkBlendMode::kModulate, paint);
+
+    SkPixmap pathFillPixels;
+    SkPixmap batchedPixels;
+    ASSERT_TRUE(pathFillSurface->peekPixels(&pathFillPixels));
+    ASSERT_TRUE(batchedSurface->peekPixels(&batchedPixels));
+    size_t coveredPixels = 0;
+    size_t differentPixels = 0;
+    for(int y = 0; y < SURFACE_SIZE; y++) {
+        for(int x = 0; x < SURFACE_SIZE; x++) {
+            uint32_t a = *pathFillPixels.addr32(x, y);
+            uint32_t b = *batchedPixels.addr32(x, y);
+            if(a != 0)
+                coveredPixels++;
+            if(a != b)
+                differentPixels++;
+        }
+    }
+    ASSERT_GT(coveredPixels, 0u);
+    EXPECT_LE(static_cast<double>(differentPixels), coveredPixels * MAXIMUM_DIFFERENT_PIXEL_FRACTION) << differentPixels << " of " << coveredPixels << " covered pixels differ";
+}
+
+TEST(MeshTriangulation, PathsWithCurvesAreLeftToThePathFill) {
+    SkPathBuilder curved;
+    curved.moveTo(0, 0);
+    curved.quadTo(50, 80, 100, 0);
+    curved.close();
+    std::shared_ptr<const MeshTriangulation> triangulation = MeshTriangulation::triangulate_path(curved.detach());
+    EXPECT_TRUE(triangulation->trianglePoints.empty());
+}